@@ -2,11 +2,26 @@
 
 #include <SDL2/SDL.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <stack>
 #include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "trace.hpp"
+
+// publishing frames is opt in like tracing, define SDLPP_FRAME_OUTPUT and compile frame_output.cpp to use it
+#ifdef SDLPP_FRAME_OUTPUT
+#include "frame_output.hpp"
+#ifndef SDLPP_HAS_FRAME_OUTPUT
+#error "SDLPP_FRAME_OUTPUT needs POSIX shared memory"
+#endif
+#endif
 
 #undef min
 
@@ -20,6 +35,8 @@ class Window {
 public:
     Window(const char* p_title, const int p_w, const int p_h);
     Window(const char* p_title, const double r_w, const double r_h);
+    Window(const Window&) = delete;
+    Window& operator=(const Window&) = delete;
     ~Window();
 
     // window related
@@ -35,6 +52,19 @@ public:
         const SDL_Rect* srcrect,
         const SDL_Rect* dstrect);
 
+    bool render_geometry(SDL_Texture* tex,
+        const SDL_Vertex* vertices, int num_vertices,
+        const int* indices, int num_indices);
+
+    // deferred drawing
+    // queued draws are submitted at display() sorted by layer, then blend mode, then texture, then depth
+    // draws with equal keys keep the order they were queued in, so overlapping draws of different textures need different layers
+    void queue(SDL_Rect src, SDL_Rect dst, SDL_Texture* tex, uint8_t layer, uint32_t depth = 0);
+    // submits everything queued so far, display() calls this before presenting
+    void flush_queue();
+
+    static uint64_t make_sort_key(uint8_t layer, SDL_BlendMode blend, SDL_Texture* tex, uint32_t depth);
+
     void display();
 
 public:
@@ -59,10 +89,132 @@ public:
     static SDL_Rect calculate_logical_rect(SDL_Rect parent, SDL_Rect child, float sim_width, float sim_height);
 
     SDL_Renderer* get_renderer();
+
+    // renderer resets
+    // listeners run once per reset, before the next frame is drawn, device_lost means every texture has to be recreated
+    // otherwise only render target textures lost their contents
+    // owner tags the listener so whoever added it can tell if this window already has one of theirs, the listeners go with the window
+    void on_renderer_reset(std::function<void(Window&, bool device_lost)> listener, const void* owner = nullptr);
+    bool has_renderer_reset_listener(const void* owner) const;
+    // goes up by one every time the device is lost, compare against it to know if a texture you own needs recreating
+    uint32_t get_reset_epoch() const;
+    // runs the listeners if a reset came in since the last call, clear() and display() already call this
+    void handle_resets();
+
+    // dirty region rendering
+    // while enabled draws are recorded instead of made right away, display() compares them against the last frame
+    // and only redraws the regions that changed into a persistent back buffer, a frame where nothing changed isnt presented at all
+    // (with vsync on, display() sleeps for a refresh instead so the loop keeps its pace)
+    // texture pixels arent compared, call invalidate when a texture you keep drawing changes its contents
+    void set_dirty_rendering(bool enabled);
+    bool get_dirty_rendering() const;
+    void invalidate(SDL_Rect rect);
+    void invalidate_all();
+    // fraction of the window redrawn by the last display(), always 1 without dirty rendering
+    float get_redrawn_fraction() const;
+
+    // frame memory
+    // transient allocations that only have to last until display(), which resets the arena
+    FrameArena& get_frame_arena();
+    // heap allocations made between the last two display() calls, only counted with SDLPP_COUNT_ALLOCATIONS
+    size_t get_frame_heap_allocations() const;
+
+#ifdef SDLPP_FRAME_OUTPUT
+    // frame output
+    // every presented frame also gets published into output, nullptr stops it, the window doesnt own output
+    // with dirty rendering a frame where nothing changed isnt presented and so isnt published either
+    void set_frame_output(FrameOutput* output);
+#endif
 private:
+    static int display_mode_size(bool height, double ratio);
+    void release_frame_memory();
+    void present();
+    static int watch_events(void* userdata, SDL_Event* event);
+    void sort_queue();
+
+    enum class DrawKind : uint8_t { Copy, FillRect, OutlineRect, Circle };
+
+    struct DrawCommand {
+        uint64_t key;
+        SDL_Texture* tex;
+        SDL_Rect src;
+        // circles keep their center in x, y and the radius in w
+        SDL_Rect dst;
+        SDL_Color color;
+        DrawKind kind;
+    };
+
+    struct GeometryBatch {
+        SDL_Texture* tex;
+        size_t first_vertex;
+        int num_vertices;
+        size_t first_index;
+        int num_indices;
+    };
+
+    static bool is_unset(SDL_Rect rect);
+    static SDL_Color texture_mod(SDL_Texture* tex);
+    static bool same_command(const DrawCommand& a, const DrawCommand& b);
+    static SDL_Rect command_bounds(const DrawCommand& command);
+    void record(DrawCommand command);
+    void execute(const DrawCommand& command);
+    void draw_circle_points(int x, int y, int r);
+    void diff_commands();
+    void merge_damage(SDL_Rect screen);
+    void present_dirty();
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
     SDL_Window* window;
     SDL_Renderer* renderer;
 
+    // declared before everything that allocates from it
+    FrameArena frame_arena;
+    size_t heap_allocation_mark = 0;
+    size_t frame_heap_allocations = 0;
+
+#ifdef SDLPP_FRAME_OUTPUT
+    FrameOutput* frame_output = nullptr;
+#endif
+
+    enum class PendingReset : uint8_t { None, Targets, Device };
+    // set from the event watch, which runs on whatever thread pumps the events, and taken by handle_resets
+    std::atomic<PendingReset> pending_reset{ PendingReset::None };
+    uint32_t reset_epoch = 0;
+
+    struct ResetListener {
+        const void* owner;
+        std::function<void(Window&, bool)> callback;
+    };
+    std::vector<ResetListener> reset_listeners;
+
+    // kept between frames so queuing doesnt allocate once it has grown, the sort buffers only live for the frame
+    std::vector<DrawCommand> draw_queue;
+    ArenaVector<SortEntry> sort_entries{ ArenaAllocator<SortEntry>(&frame_arena) };
+    ArenaVector<SortEntry> sort_scratch{ ArenaAllocator<SortEntry>(&frame_arena) };
+
+    bool dirty_rendering = false;
+    // the event watch sets this too
+    std::atomic<bool> full_damage{ true };
+    float redrawn_fraction = 1.f;
+    SDL_Color clear_color = { 0, 0, 0, 255 };
+    SDL_Color prev_clear_color = { 0, 0, 0, 255 };
+    SDL_Texture* back_buffer = nullptr;
+    int back_buffer_w = 0;
+    int back_buffer_h = 0;
+    std::vector<DrawCommand> frame_commands;
+    std::vector<DrawCommand> prev_commands;
+    std::vector<SDL_Rect> damage;
+    // geometry isnt diffed, it is drawn over the back buffer every frame it is submitted
+    // and the frame after the last one that had any is presented too, so it doesnt stay on screen
+    bool had_geometry = false;
+    ArenaVector<SDL_Vertex> geometry_vertices{ ArenaAllocator<SDL_Vertex>(&frame_arena) };
+    ArenaVector<int> geometry_indices{ ArenaAllocator<int>(&frame_arena) };
+    ArenaVector<GeometryBatch> geometry_batches{ ArenaAllocator<GeometryBatch>(&frame_arena) };
+
 
     std::stack<SDL_Color> colors;
 };
@@ -113,22 +265,24 @@ inline Window::Window(const char* p_title, const int p_w, const int p_h)
 
     // ...and the surface containing the icon pixel data is no longer required.
     SDL_FreeSurface(surface);
+
+    SDL_AddEventWatch(&Window::watch_events, this);
 }
 
-inline Window::Window(const char* p_title, const double r_w, const double r_h) {
+// sizes the window as a fraction of the current display mode
+inline Window::Window(const char* p_title, const double r_w, const double r_h)
+    : Window(p_title, display_mode_size(false, r_w), display_mode_size(true, r_h)) {}
+
+inline int Window::display_mode_size(bool height, double ratio) {
     SDL_DisplayMode mode{};
     SDL_GetCurrentDisplayMode(0, &mode);
-
-    // call the other constructor
-    auto tmp = Window(p_title, int(mode.w * r_w), int(mode.h * r_h));
-
-    *this = tmp;
-
-    tmp.renderer = NULL;
-    tmp.window = NULL;
+    return int((height ? mode.h : mode.w) * ratio);
 }
 
 inline Window::~Window() {
+    SDL_DelEventWatch(&Window::watch_events, this);
+    if (back_buffer)
+        SDL_DestroyTexture(back_buffer);
     SDL_DestroyRenderer(this->renderer);
     SDL_DestroyWindow(this->window);
 }
@@ -157,6 +311,13 @@ inline void Window::set_title(const char* title) {
 // passing in a src with all zeros will grab the entire texture
 // returns weather it worked or not
 inline bool Window::render(SDL_Rect src, SDL_Rect dst, SDL_Texture* tex) {
+    SDLPP_TRACE_SCOPE("Window::render");
+
+    if (dirty_rendering) {
+        record({ 0, tex, src, dst, texture_mod(tex), DrawKind::Copy });
+        return true;
+    }
+
     auto checkIfSet = [](SDL_Rect box) {if ((box.x == 0) && (box.y == 0) && (box.w == 0) && (box.h == 0)) return true; else return false; };
 
     auto err = SDL_RenderCopy(this->renderer, tex, (checkIfSet(src)) ? NULL : &src, &dst);
@@ -169,18 +330,248 @@ inline bool Window::render(SDL_Rect src, SDL_Rect dst, SDL_Texture* tex) {
 }
 
 inline void Window::render_copy(SDL_Texture* texture, const SDL_Rect* srcrect, const SDL_Rect* dstrect) {
+    if (dirty_rendering) {
+        SDL_Rect screen = { 0, 0, 0, 0 };
+        SDL_GetRendererOutputSize(renderer, &screen.w, &screen.h);
+        record({ 0, texture, srcrect ? *srcrect : SDL_Rect{ 0, 0, 0, 0 }, dstrect ? *dstrect : screen, texture_mod(texture), DrawKind::Copy });
+        return;
+    }
+
     SDL_RenderCopy(renderer, texture, srcrect, dstrect);
 }
 
+// draws a batch of triangles in one call, indices may be NULL to draw the vertices in order
+// returns weather it worked or not
+inline bool Window::render_geometry(SDL_Texture* tex, const SDL_Vertex* vertices, int num_vertices, const int* indices, int num_indices) {
+    if (dirty_rendering) {
+        geometry_batches.push_back({ tex, geometry_vertices.size(), num_vertices, geometry_indices.size(), indices ? num_indices : 0 });
+        geometry_vertices.insert(geometry_vertices.end(), vertices, vertices + num_vertices);
+        if (indices)
+            geometry_indices.insert(geometry_indices.end(), indices, indices + num_indices);
+        return true;
+    }
+
+    auto err = SDL_RenderGeometry(this->renderer, tex, vertices, num_vertices, indices, num_indices);
+
+    if (err != 0) {
+        SDL_Log("SDL2 Error: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
 inline SDL_Renderer* Window::get_renderer() {
     return renderer;
 }
 
-inline void Window::display() { SDL_RenderPresent(this->renderer); }
+inline uint64_t Window::make_sort_key(uint8_t layer, SDL_BlendMode blend, SDL_Texture* tex, uint32_t depth) {
+    uint64_t blend_bits;
+    switch (blend) {
+    case SDL_BLENDMODE_NONE:  blend_bits = 0; break;
+    case SDL_BLENDMODE_BLEND: blend_bits = 1; break;
+    case SDL_BLENDMODE_ADD:   blend_bits = 2; break;
+    case SDL_BLENDMODE_MOD:   blend_bits = 3; break;
+    case SDL_BLENDMODE_MUL:   blend_bits = 4; break;
+    default:                  blend_bits = 15; break;
+    }
+
+    // the texture only has to group equal textures together, so a 20 bit hash of the pointer is enough
+    // a collision just means two textures share a group, the order stays correct
+    const uint64_t texture_bits = ((reinterpret_cast<uintptr_t>(tex) >> 4) * 0x9E3779B97F4A7C15ull) >> 44;
+
+    //  layer | blend | texture | depth
+    //  63-56 | 55-52 |  51-32  |  31-0
+    return (uint64_t(layer) << 56) | (blend_bits << 52) | (texture_bits << 32) | depth;
+}
+
+inline void Window::queue(SDL_Rect src, SDL_Rect dst, SDL_Texture* tex, uint8_t layer, uint32_t depth) {
+    SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+    SDL_GetTextureBlendMode(tex, &blend);
+
+    draw_queue.push_back({ make_sort_key(layer, blend, tex, depth), tex, src, dst, texture_mod(tex), DrawKind::Copy });
+}
+
+// least significant digit radix sort over the keys, a byte at a time, which keeps equal keys in queue order
+// passes where every key has the same byte are skipped, so a queue on a single layer only pays for the bytes that differ
+inline void Window::sort_queue() {
+    const size_t count = draw_queue.size();
+    sort_entries.resize(count);
+    sort_scratch.resize(count);
+
+    size_t histograms[8][256] = {};
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t key = draw_queue[i].key;
+        sort_entries[i] = { key, uint32_t(i) };
+        for (int pass = 0; pass < 8; ++pass)
+            ++histograms[pass][(key >> (pass * 8)) & 0xff];
+    }
+
+    for (int pass = 0; pass < 8; ++pass) {
+        size_t* histogram = histograms[pass];
+        const int shift = pass * 8;
+
+        if (histogram[(sort_entries[0].key >> shift) & 0xff] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            const size_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+
+        for (const SortEntry& entry : sort_entries)
+            sort_scratch[histogram[(entry.key >> shift) & 0xff]++] = entry;
+
+        sort_entries.swap(sort_scratch);
+    }
+}
+
+inline void Window::flush_queue() {
+    if (draw_queue.empty())
+        return;
+
+    sort_queue();
+
+    for (const SortEntry& entry : sort_entries) {
+        const DrawCommand& command = draw_queue[entry.index];
+        if (dirty_rendering)
+            record(command);
+        else
+            execute(command);
+    }
 
-inline void Window::clear() { SDL_RenderClear(this->renderer); }
+    draw_queue.clear();
+}
+
+inline void Window::display() {
+    {
+        SDLPP_TRACE_SCOPE("Window::display");
+
+        flush_queue();
+        if (dirty_rendering)
+            present_dirty();
+        else
+            present();
+        handle_resets();
+
+        release_frame_memory();
+
+        const size_t allocations = heap_allocation_count();
+        frame_heap_allocations = allocations - heap_allocation_mark;
+        heap_allocation_mark = allocations;
+    }
+    // after the zone above closed, so a trace written by a frame trigger includes it
+    SDLPP_TRACE_FRAME();
+}
+
+// the back buffer is only defined until it is presented, so the frame output has to read it right before
+inline void Window::present() {
+#ifdef SDLPP_FRAME_OUTPUT
+    if (frame_output)
+        frame_output->publish(renderer);
+#endif
+    SDL_RenderPresent(renderer);
+}
+
+#ifdef SDLPP_FRAME_OUTPUT
+inline void Window::set_frame_output(FrameOutput* output) {
+    frame_output = output;
+}
+#endif
+
+// the arena backed buffers have to let go of their memory before the arena hands it out again
+inline void Window::release_frame_memory() {
+    ArenaVector<SortEntry>(ArenaAllocator<SortEntry>(&frame_arena)).swap(sort_entries);
+    ArenaVector<SortEntry>(ArenaAllocator<SortEntry>(&frame_arena)).swap(sort_scratch);
+    ArenaVector<SDL_Vertex>(ArenaAllocator<SDL_Vertex>(&frame_arena)).swap(geometry_vertices);
+    ArenaVector<int>(ArenaAllocator<int>(&frame_arena)).swap(geometry_indices);
+    ArenaVector<GeometryBatch>(ArenaAllocator<GeometryBatch>(&frame_arena)).swap(geometry_batches);
+
+    frame_arena.reset();
+}
+
+inline FrameArena& Window::get_frame_arena() {
+    return frame_arena;
+}
+
+inline size_t Window::get_frame_heap_allocations() const {
+    return frame_heap_allocations;
+}
 
-inline void Window::draw_circle(int X, int Y, int r) {
+inline void Window::clear() {
+    handle_resets();
+    if (dirty_rendering) {
+        // the background is filled in per damaged region when the frame is presented
+        get_draw_color(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
+        return;
+    }
+    SDL_RenderClear(this->renderer);
+}
+
+inline int Window::watch_events(void* userdata, SDL_Event* event) {
+    auto self = static_cast<Window*>(userdata);
+
+    if (event->type == SDL_RENDER_DEVICE_RESET) {
+        self->pending_reset.store(PendingReset::Device);
+    } else if (event->type == SDL_RENDER_TARGETS_RESET) {
+        // never downgrades a pending device reset
+        PendingReset expected = PendingReset::None;
+        self->pending_reset.compare_exchange_strong(expected, PendingReset::Targets);
+    } else if (event->type == SDL_WINDOWEVENT && event->window.windowID == SDL_GetWindowID(self->window)
+        && (event->window.event == SDL_WINDOWEVENT_EXPOSED || event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+        self->full_damage = true;
+    }
+
+    return 0;
+}
+
+inline void Window::on_renderer_reset(std::function<void(Window&, bool device_lost)> listener, const void* owner) {
+    reset_listeners.push_back({ owner, std::move(listener) });
+}
+
+inline bool Window::has_renderer_reset_listener(const void* owner) const {
+    return std::any_of(reset_listeners.begin(), reset_listeners.end(),
+        [owner](const ResetListener& listener) { return listener.owner == owner; });
+}
+
+inline uint32_t Window::get_reset_epoch() const {
+    return reset_epoch;
+}
+
+inline void Window::handle_resets() {
+    if (pending_reset.load(std::memory_order_relaxed) == PendingReset::None) [[likely]]
+        return;
+
+    // taken in one step so a reset arriving meanwhile is either handled now or left for the next call
+    const bool device_lost = pending_reset.exchange(PendingReset::None) == PendingReset::Device;
+    if (device_lost)
+        ++reset_epoch;
+
+    // a lost device takes every texture with it, present_dirty makes a new back buffer
+    if (device_lost && back_buffer) {
+        SDL_DestroyTexture(back_buffer);
+        back_buffer = nullptr;
+    }
+
+    // the back buffer is a render target, so either kind of reset takes its contents
+    full_damage = true;
+
+    for (auto& listener : reset_listeners)
+        listener.callback(*this, device_lost);
+}
+
+inline void Window::draw_circle(int x, int y, int r) {
+    if (dirty_rendering) {
+        SDL_Color c;
+        get_draw_color(c.r, c.g, c.b, c.a);
+        record({ 0, nullptr, {}, { x, y, r, 0 }, c, DrawKind::Circle });
+        return;
+    }
+    draw_circle_points(x, y, r);
+}
+
+inline void Window::draw_circle_points(int X, int Y, int r) {
     const int32_t diameter = (r * 2);
 
     int32_t x = (r - 1);
@@ -217,13 +608,255 @@ inline void Window::draw_circle(int X, int Y, int r) {
 }
 
 inline void Window::draw_rect_outline(SDL_Rect rec) {
+    if (dirty_rendering) {
+        SDL_Color c;
+        get_draw_color(c.r, c.g, c.b, c.a);
+        record({ 0, nullptr, {}, rec, c, DrawKind::OutlineRect });
+        return;
+    }
     SDL_RenderDrawRect(renderer, &rec);
 }
 
 inline void Window::draw_rect_filled(SDL_Rect rec) {
+    if (dirty_rendering) {
+        SDL_Color c;
+        get_draw_color(c.r, c.g, c.b, c.a);
+        record({ 0, nullptr, {}, rec, c, DrawKind::FillRect });
+        return;
+    }
     SDL_RenderFillRect(renderer, &rec);
 }
 
+inline void Window::set_dirty_rendering(bool enabled) {
+    dirty_rendering = enabled;
+    full_damage = true;
+    redrawn_fraction = 1.f;
+
+    frame_commands.clear();
+    prev_commands.clear();
+    damage.clear();
+
+    if (!enabled && back_buffer) {
+        SDL_DestroyTexture(back_buffer);
+        back_buffer = nullptr;
+    }
+}
+
+inline bool Window::get_dirty_rendering() const {
+    return dirty_rendering;
+}
+
+// only present_dirty clears the damage, so without dirty rendering there is nothing to collect it for
+inline void Window::invalidate(SDL_Rect rect) {
+    if (dirty_rendering && rect.w > 0 && rect.h > 0)
+        damage.push_back(rect);
+}
+
+inline void Window::invalidate_all() {
+    full_damage = true;
+}
+
+inline float Window::get_redrawn_fraction() const {
+    return redrawn_fraction;
+}
+
+inline bool Window::is_unset(SDL_Rect rect) {
+    return rect.x == 0 && rect.y == 0 && rect.w == 0 && rect.h == 0;
+}
+
+// copies keep the modulation the texture had when they were made, so a texture tinted differently
+// by several draws replays each of them right, and a tint change counts as a changed command
+inline SDL_Color Window::texture_mod(SDL_Texture* tex) {
+    SDL_Color mod = { 255, 255, 255, 255 };
+    SDL_GetTextureColorMod(tex, &mod.r, &mod.g, &mod.b);
+    SDL_GetTextureAlphaMod(tex, &mod.a);
+    return mod;
+}
+
+inline bool Window::same_command(const DrawCommand& a, const DrawCommand& b) {
+    return a.kind == b.kind && a.tex == b.tex
+        && a.src.x == b.src.x && a.src.y == b.src.y && a.src.w == b.src.w && a.src.h == b.src.h
+        && a.dst.x == b.dst.x && a.dst.y == b.dst.y && a.dst.w == b.dst.w && a.dst.h == b.dst.h
+        && a.color.r == b.color.r && a.color.g == b.color.g && a.color.b == b.color.b && a.color.a == b.color.a;
+}
+
+inline SDL_Rect Window::command_bounds(const DrawCommand& command) {
+    if (command.kind == DrawKind::Circle) {
+        const int r = command.dst.w;
+        return { command.dst.x - r, command.dst.y - r, 2 * r + 1, 2 * r + 1 };
+    }
+    return command.dst;
+}
+
+inline void Window::record(DrawCommand command) {
+    frame_commands.push_back(command);
+}
+
+inline void Window::execute(const DrawCommand& command) {
+    switch (command.kind) {
+    case DrawKind::Copy:
+        SDL_SetTextureColorMod(command.tex, command.color.r, command.color.g, command.color.b);
+        SDL_SetTextureAlphaMod(command.tex, command.color.a);
+        SDL_RenderCopy(renderer, command.tex, is_unset(command.src) ? NULL : &command.src, &command.dst);
+        break;
+    case DrawKind::FillRect:
+        SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+        SDL_RenderFillRect(renderer, &command.dst);
+        break;
+    case DrawKind::OutlineRect:
+        SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+        SDL_RenderDrawRect(renderer, &command.dst);
+        break;
+    case DrawKind::Circle:
+        SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+        draw_circle_points(command.dst.x, command.dst.y, command.dst.w);
+        break;
+    }
+}
+
+// every command that differs from the one in the same position last frame damages both where it was and where it is
+inline void Window::diff_commands() {
+    const size_t common = std::min(prev_commands.size(), frame_commands.size());
+
+    for (size_t i = 0; i < common; ++i) {
+        if (same_command(prev_commands[i], frame_commands[i]))
+            continue;
+        invalidate(command_bounds(prev_commands[i]));
+        invalidate(command_bounds(frame_commands[i]));
+    }
+
+    for (size_t i = common; i < prev_commands.size(); ++i)
+        invalidate(command_bounds(prev_commands[i]));
+    for (size_t i = common; i < frame_commands.size(); ++i)
+        invalidate(command_bounds(frame_commands[i]));
+}
+
+// clips the damage to the screen and merges overlapping rects until none overlap
+// past a handful of rects the clip changes cost more than they save, so they collapse into one
+inline void Window::merge_damage(SDL_Rect screen) {
+    constexpr size_t max_regions = 16;
+
+    size_t count = 0;
+    for (const SDL_Rect& rect : damage) {
+        SDL_Rect clipped;
+        if (SDL_IntersectRect(&rect, &screen, &clipped))
+            damage[count++] = clipped;
+    }
+    damage.resize(count);
+
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < damage.size(); ++i) {
+            for (size_t j = i + 1; j < damage.size();) {
+                if (SDL_HasIntersection(&damage[i], &damage[j])) {
+                    SDL_UnionRect(&damage[i], &damage[j], &damage[i]);
+                    damage[j] = damage.back();
+                    damage.pop_back();
+                    merged = true;
+                } else {
+                    ++j;
+                }
+            }
+        }
+    }
+
+    if (damage.size() > max_regions) {
+        for (size_t i = 1; i < damage.size(); ++i)
+            SDL_UnionRect(&damage[0], &damage[i], &damage[0]);
+        damage.resize(1);
+    }
+}
+
+inline void Window::present_dirty() {
+    SDL_Rect screen = { 0, 0, 0, 0 };
+    SDL_GetRendererOutputSize(renderer, &screen.w, &screen.h);
+
+    if (back_buffer == nullptr || screen.w != back_buffer_w || screen.h != back_buffer_h) {
+        if (back_buffer)
+            SDL_DestroyTexture(back_buffer);
+        back_buffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, screen.w, screen.h);
+        // it replaces the whole screen, blending it would mix in whatever the screen had before
+        SDL_SetTextureBlendMode(back_buffer, SDL_BLENDMODE_NONE);
+        back_buffer_w = screen.w;
+        back_buffer_h = screen.h;
+        full_damage = true;
+    }
+
+    const SDL_Color c = clear_color;
+    const SDL_Color p = prev_clear_color;
+    if (c.r != p.r || c.g != p.g || c.b != p.b || c.a != p.a)
+        full_damage = true;
+
+    if (full_damage) {
+        damage.clear();
+        damage.push_back(screen);
+    } else {
+        diff_commands();
+    }
+    merge_damage(screen);
+
+    size_t pixels = 0;
+    for (const SDL_Rect& region : damage)
+        pixels += size_t(region.w) * size_t(region.h);
+    redrawn_fraction = screen.w > 0 && screen.h > 0 ? float(pixels) / (float(screen.w) * float(screen.h)) : 0.f;
+
+    // with nothing damaged and nothing drawn over the top now or last frame, the screen already shows this frame
+    const bool has_geometry = !geometry_batches.empty();
+    if (!damage.empty() || has_geometry || had_geometry) {
+        Uint8 r, g, b, a;
+        get_draw_color(r, g, b, a);
+
+        if (!damage.empty()) {
+            SDL_SetRenderTarget(renderer, back_buffer);
+
+            for (const SDL_Rect& region : damage) {
+                SDL_RenderSetClipRect(renderer, &region);
+                SDL_SetRenderDrawColor(renderer, clear_color.r, clear_color.g, clear_color.b, clear_color.a);
+                SDL_RenderFillRect(renderer, &region);
+
+                for (const DrawCommand& command : frame_commands) {
+                    const SDL_Rect bounds = command_bounds(command);
+                    if (SDL_HasIntersection(&bounds, &region))
+                        execute(command);
+                }
+            }
+
+            SDL_RenderSetClipRect(renderer, NULL);
+            SDL_SetRenderTarget(renderer, NULL);
+        }
+
+        SDL_RenderCopy(renderer, back_buffer, NULL, NULL);
+
+        for (const GeometryBatch& batch : geometry_batches) {
+            SDL_RenderGeometry(renderer, batch.tex,
+                geometry_vertices.data() + batch.first_vertex, batch.num_vertices,
+                batch.num_indices ? geometry_indices.data() + batch.first_index : NULL, batch.num_indices);
+        }
+
+        SDL_SetRenderDrawColor(renderer, r, g, b, a);
+        present();
+    } else {
+        // presenting is what waited for vsync, without it a vsync paced loop would spin through idle frames
+        SDL_RendererInfo info{};
+        if (SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC)) {
+            const int refresh_rate = get_refresh_rate();
+            SDL_Delay(1000 / Uint32(refresh_rate > 0 ? refresh_rate : 60));
+        }
+    }
+    had_geometry = has_geometry;
+
+    prev_commands.swap(frame_commands);
+    frame_commands.clear();
+    prev_clear_color = clear_color;
+    damage.clear();
+    full_damage = false;
+
+    geometry_vertices.clear();
+    geometry_indices.clear();
+    geometry_batches.clear();
+}
+
 inline SDL_Texture* Window::create_texture_from_surface(SDL_Surface* surface) {
     return SDL_CreateTextureFromSurface(this->renderer, surface);
 }
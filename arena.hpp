@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// a bump allocator for memory that only has to live until the end of the frame
+// everything handed out is released at once by reset(), which Window::display() calls
+class FrameArena {
+public:
+    explicit FrameArena(size_t block_size = 64 * 1024);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t align);
+    // frees everything at once, if the frame needed more than one block they get replaced by a single
+    // block big enough for all of it, so a steady frame ends up never touching the heap
+    void reset();
+
+    size_t used() const;
+    size_t capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void add_block(size_t min_size);
+
+    std::vector<Block> blocks;
+    size_t block_size;
+    // bytes used in the last block, every block before it is full
+    size_t offset = 0;
+    size_t used_before = 0;
+};
+
+// std allocator adapter over a FrameArena, deallocate does nothing since reset() frees everything
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena* arena) noexcept : arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// how many times operator new has run since the program started
+// only counts when built with SDLPP_COUNT_ALLOCATIONS, which also needs arena.cpp, otherwise it is always 0
+#ifdef SDLPP_COUNT_ALLOCATIONS
+size_t heap_allocation_count();
+#else
+inline size_t heap_allocation_count() { return 0; }
+#endif
+
+//
+// IMPLEMENTATION
+//
+
+inline FrameArena::FrameArena(size_t block_size) : block_size(block_size) {
+    add_block(block_size);
+}
+
+inline void FrameArena::add_block(size_t min_size) {
+    const size_t size = min_size > block_size ? min_size : block_size;
+    blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+}
+
+inline void* FrameArena::allocate(size_t size, size_t align) {
+    Block* block = &blocks.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block->data.get());
+    uintptr_t aligned = (base + offset + align - 1) & ~uintptr_t(align - 1);
+
+    if (aligned + size > base + block->size) [[unlikely]] {
+        used_before += offset;
+        add_block(size + align);
+        offset = 0;
+
+        block = &blocks.back();
+        base = reinterpret_cast<uintptr_t>(block->data.get());
+        aligned = (base + align - 1) & ~uintptr_t(align - 1);
+    }
+
+    offset = aligned + size - base;
+    return reinterpret_cast<void*>(aligned);
+}
+
+inline void FrameArena::reset() {
+    if (blocks.size() > 1) [[unlikely]] {
+        const size_t total = capacity();
+        blocks.clear();
+        add_block(total);
+    }
+    offset = 0;
+    used_before = 0;
+}
+
+inline size_t FrameArena::used() const {
+    return used_before + offset;
+}
+
+inline size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks)
+        total += block.size;
+    return total;
+}
@@ -0,0 +1,98 @@
+#include "collision.hpp"
+
+#include <algorithm>
+
+CollisionMask CollisionMask::fromSurface(SDL_Surface* surface, SDL_Rect region, uint8_t alphaThreshold) {
+	CollisionMask mask;
+	if (surface == nullptr)
+		return mask;
+
+	// keep the region inside the surface
+	const SDL_Rect whole = { 0, 0, surface->w, surface->h };
+	if (!SDL_IntersectRect(&region, &whole, &region))
+		return mask;
+
+	SDL_Surface* pixels = surface;
+	if (surface->format->BytesPerPixel != 4) {
+		pixels = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (pixels == nullptr)
+			return mask;
+	}
+
+	mask.w = region.w;
+	mask.h = region.h;
+	mask.wordsPerRow = (region.w + 63) / 64;
+	mask.bits.assign(size_t(mask.wordsPerRow) * region.h, 0);
+
+	const Uint32 amask = pixels->format->Amask;
+	const Uint8 ashift = pixels->format->Ashift;
+
+	int32_t minX = region.w, minY = region.h, maxX = -1, maxY = -1;
+
+	if (SDL_MUSTLOCK(pixels))
+		SDL_LockSurface(pixels);
+
+	for (int32_t y = 0; y < region.h; ++y) {
+		const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(pixels->pixels) + (region.y + y) * pixels->pitch) + region.x;
+		uint64_t* words = &mask.bits[size_t(y) * mask.wordsPerRow];
+
+		for (int32_t x = 0; x < region.w; ++x) {
+			const bool isSolid = amask == 0 || ((row[x] & amask) >> ashift) > alphaThreshold;
+			if (!isSolid)
+				continue;
+
+			words[x >> 6] |= uint64_t(1) << (x & 63);
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+		}
+	}
+
+	if (SDL_MUSTLOCK(pixels))
+		SDL_UnlockSurface(pixels);
+
+	if (pixels != surface)
+		SDL_FreeSurface(pixels);
+
+	if (maxX >= 0)
+		mask.solid = { minX, minY, maxX - minX + 1, maxY - minY + 1 };
+
+	return mask;
+}
+
+bool CollisionMask::overlaps(int32_t x, int32_t y, const CollisionMask& other, int32_t otherX, int32_t otherY) const {
+	if (empty() || other.empty())
+		return false;
+
+	// early out on the solid bounds, which also limits the word loop below to where both can have pixels
+	const SDL_Rect a = { x + solid.x, y + solid.y, solid.w, solid.h };
+	const SDL_Rect b = { otherX + other.solid.x, otherY + other.solid.y, other.solid.w, other.solid.h };
+
+	SDL_Rect overlap;
+	if (!SDL_IntersectRect(&a, &b, &overlap))
+		return false;
+
+	for (int32_t row = overlap.y; row < overlap.y + overlap.h; ++row) {
+		const int32_t rowA = row - y;
+		const int32_t rowB = row - otherY;
+
+		for (int32_t col = overlap.x; col < overlap.x + overlap.w; col += 64) {
+			uint64_t hit = bitsAt(rowA, col - x) & other.bitsAt(rowB, col - otherX);
+
+			const int32_t remaining = overlap.x + overlap.w - col;
+			if (remaining < 64)
+				hit &= (uint64_t(1) << remaining) - 1;
+
+			if (hit)
+				return true;
+		}
+	}
+	return false;
+}
+
+bool CollisionMask::test(int32_t x, int32_t y) const {
+	if (x < 0 || y < 0 || x >= w || y >= h)
+		return false;
+	return (bits[size_t(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+// 1 bit per pixel solidity mask, rows are packed into 64 bit words so overlap tests compare 64 pixels at a time
+// pixel x of a row is bit x % 64 of word x / 64
+class CollisionMask {
+public:
+	CollisionMask() = default;
+
+	// a pixel of region is solid when its alpha is above alphaThreshold, surfaces without alpha are solid everywhere
+	static CollisionMask fromSurface(SDL_Surface* surface, SDL_Rect region, uint8_t alphaThreshold = 0);
+
+	// this mask with its top left at (x, y) against other with its top left at (otherX, otherY)
+	bool overlaps(int32_t x, int32_t y, const CollisionMask& other, int32_t otherX, int32_t otherY) const;
+	bool test(int32_t x, int32_t y) const;
+
+	int32_t width() const { return w; }
+	int32_t height() const { return h; }
+	// tightest rect around the solid pixels, relative to the top left of the mask
+	SDL_Rect bounds() const { return solid; }
+	bool empty() const { return solid.w == 0; }
+
+private:
+	// the 64 pixels of row starting at column start, anything past the end of the row reads as empty
+	inline uint64_t bitsAt(int32_t row, int32_t start) const {
+		const uint64_t* words = &bits[size_t(row) * wordsPerRow];
+		const int32_t word = start >> 6;
+		const int32_t shift = start & 63;
+
+		uint64_t out = words[word] >> shift;
+		if (shift != 0 && word + 1 < wordsPerRow)
+			out |= words[word + 1] << (64 - shift);
+		return out;
+	}
+
+	int32_t w = 0;
+	int32_t h = 0;
+	int32_t wordsPerRow = 0;
+	SDL_Rect solid = { 0, 0, 0, 0 };
+	std::vector<uint64_t> bits;
+};
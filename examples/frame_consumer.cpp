@@ -0,0 +1,69 @@
+// reads the frames a Window publishes through FrameOutput and writes them to stdout as raw video,
+// reporting frames and bytes per second on stderr
+//
+//     g++ -std=c++20 -O2 examples/frame_consumer.cpp frame_output.cpp -lSDL2 -o frame_consumer
+//     ./frame_consumer sdlpp_frames | ffmpeg -f rawvideo -pixel_format bgra -video_size 1920x1080 -i - out.mp4
+//
+// ARGB8888 is b, g, r, a in memory on little endian machines, hence bgra
+// frames smaller than the ring are padded out to the ring size so every frame on stdout has the same size
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "../frame_output.hpp"
+
+int main(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : "sdlpp_frames";
+
+    try {
+        FrameReader reader(name);
+        const FrameRingHeader& header = reader.get_header();
+        std::fprintf(stderr, "%s: %dx%d, %u slots\n", name, header.width, header.height, header.slot_count);
+
+        // the frame is only checked after using it, so it is written from a local copy that a torn frame never reaches
+        std::vector<uint8_t> out(size_t(header.pitch) * header.height);
+        FrameReader::Frame frame;
+
+        uint64_t frames = 0, bytes = 0, dropped = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (;;) {
+            if (!reader.next(frame)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+                continue;
+            }
+
+            std::fill(out.begin(), out.end(), 0);
+            for (int y = 0; y < frame.height; ++y)
+                std::memcpy(out.data() + size_t(y) * header.pitch, frame.pixels + size_t(y) * frame.pitch, size_t(frame.width) * 4);
+
+            // the writer got around the ring and into this slot while we copied it
+            if (!FrameReader::still_valid(frame)) {
+                ++dropped;
+                continue;
+            }
+
+            if (std::fwrite(out.data(), 1, out.size(), stdout) != out.size())
+                return 0;
+
+            ++frames;
+            bytes += uint64_t(frame.pitch) * frame.height;
+
+            const auto now = std::chrono::steady_clock::now();
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            if (seconds >= 1.0) {
+                std::fprintf(stderr, "%.1f fps, %.1f MB/s, %llu torn\n",
+                    frames / seconds, bytes / seconds / 1e6, (unsigned long long)dropped);
+                frames = bytes = dropped = 0;
+                start = now;
+            }
+        }
+    } catch (const std::exception& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,105 @@
+// measures how fast frames get through a FrameOutput ring into a FrameReader in another process
+// the producer stamps every pixel of a frame with its index, the consumer checks them, so this also
+// catches frames that were handed out while being overwritten
+//
+//     g++ -std=c++20 -O2 examples/frame_throughput.cpp frame_output.cpp -lSDL2 -o frame_throughput
+//     ./frame_throughput [width] [height] [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../frame_output.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+static int consume(const char* name, uint64_t count) {
+    FrameReader reader(name);
+    FrameReader::Frame frame;
+
+    uint64_t received = 0, torn = 0, wrong = 0, bytes = 0;
+    const auto start = clock_type::now();
+
+    while (true) {
+        if (!reader.next(frame)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // a sparse sample is enough to notice a frame mixing two indices
+        const uint32_t expected = uint32_t(frame.index);
+        bool same = true;
+        for (int y = 0; y < frame.height && same; y += 7) {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(frame.pixels + size_t(y) * frame.pitch);
+            for (int x = 0; x < frame.width; x += 13)
+                same = same && row[x] == expected;
+        }
+
+        if (!FrameReader::still_valid(frame)) {
+            ++torn;
+        } else {
+            ++received;
+            bytes += uint64_t(frame.pitch) * frame.height;
+            wrong += !same;
+        }
+
+        if (frame.index >= count)
+            break;
+    }
+
+    const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("consumer: %llu frames, %.1f fps, %.2f GB/s, %llu torn and skipped, %llu inconsistent\n",
+        (unsigned long long)received, received / seconds, bytes / seconds / 1e9,
+        (unsigned long long)torn, (unsigned long long)wrong);
+    std::fflush(stdout);
+    return wrong == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const int width = argc > 1 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const uint64_t count = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 2000;
+    const char* name = "sdlpp_frame_throughput";
+
+    try {
+        FrameOutput output(name, width, height, 4);
+
+        const pid_t consumer = fork();
+        if (consumer == 0) {
+            // the child shares output with the parent, it must never unwind into ~FrameOutput and unlink the ring
+            try {
+                _exit(consume(name, count));
+            } catch (const std::exception& error) {
+                std::fprintf(stderr, "consumer: %s\n", error.what());
+                _exit(1);
+            }
+        }
+
+        std::vector<uint32_t> pixels(size_t(width) * height);
+        const auto start = clock_type::now();
+
+        for (uint64_t i = 1; i <= count; ++i) {
+            std::fill(pixels.begin(), pixels.end(), uint32_t(i));
+            output.publish(pixels.data(), width * 4, width, height);
+        }
+
+        const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+        std::printf("producer: %llu frames of %dx%d, %.1f fps, %.2f GB/s (including filling the frames)\n",
+            (unsigned long long)count, width, height, count / seconds, count * double(width) * height * 4 / seconds / 1e9);
+        std::fflush(stdout);
+
+        int status = 0;
+        waitpid(consumer, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    } catch (const std::exception& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,58 @@
+// times ParticleEmitter::update and the vertex building render does, with no window or renderer,
+// against the 16.7 ms a 60 Hz frame has, on the one core it runs on
+//
+//     g++ -std=c++20 -O2 -march=native examples/particle_benchmark.cpp particles.cpp texture.cpp preprocess.cpp
+//         collision.cpp raster.cpp -lSDL2 -lSDL2_image -o particle_benchmark
+//     ./particle_benchmark [particles] [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../particles.hpp"
+
+int main(int argc, char** argv) {
+    const size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 600;
+    const float dt = 1.f / 60.f;
+
+    ParticleEmitter emitter(capacity);
+    emitter.settings.x = 640.f;
+    emitter.settings.y = 360.f;
+    emitter.settings.spread = 20.f;
+    emitter.settings.gravityY = 98.f;
+    emitter.settings.minLife = 1.f;
+    emitter.settings.maxLife = 2.f;
+    // spawning at the rate particles die keeps the pool close to full, which is the expensive case
+    emitter.settings.rate = float(capacity) / 1.5f;
+    emitter.emit(capacity);
+
+    // lets the spawning and dying settle before measuring
+    for (int i = 0; i < 120; ++i)
+        emitter.update(dt);
+
+    using clock = std::chrono::steady_clock;
+    double total = 0.0, worst = 0.0;
+    size_t particles = 0;
+    // printed so the vertex building cant be optimized away
+    double checksum = 0.0;
+
+    for (int i = 0; i < frames; ++i) {
+        const auto start = clock::now();
+        emitter.update(dt);
+        const SDL_Vertex* vertices = emitter.buildVertices();
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        if (emitter.size())
+            checksum += vertices[(emitter.size() - 1) * 4].position.x;
+        total += ms;
+        worst = std::max(worst, ms);
+        particles += emitter.size();
+    }
+
+    const double average = total / frames;
+    std::printf("%zu particles on average over %d frames: %.3f ms per frame on average, %.3f ms worst (%s a 60 Hz frame), checksum %g\n",
+        particles / size_t(frames), frames, average, worst, worst < 1000.0 / 60.0 ? "fits in" : "does NOT fit in", checksum);
+    return worst < 1000.0 / 60.0 ? 0 : 1;
+}
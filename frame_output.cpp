@@ -0,0 +1,217 @@
+#include "frame_output.hpp"
+
+#ifdef SDLPP_HAS_FRAME_OUTPUT
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string shm_name(std::string name) {
+    if (name.empty() || name[0] != '/')
+        name.insert(name.begin(), '/');
+    return name;
+}
+
+static std::runtime_error shm_error(const char* what, const std::string& name) {
+    return std::runtime_error(std::string(what) + " " + name + " failed because: " + std::strerror(errno));
+}
+
+FrameOutput::FrameOutput(std::string name, int width, int height, uint32_t slot_count) : name(shm_name(std::move(name))) {
+    if (width <= 0 || height <= 0 || slot_count == 0)
+        throw std::runtime_error("FrameOutput needs a positive size and at least one slot");
+
+    const int32_t pitch = width * 4;
+    // slots start on a cache line so a slot header never shares one with the previous frames pixels
+    const uint64_t slot_stride = (frame_header_size + uint64_t(pitch) * uint64_t(height) + 63) & ~uint64_t(63);
+    size = size_t(frame_header_size + slot_stride * slot_count);
+
+    // whatever an earlier run left behind may have another size
+    shm_unlink(this->name.c_str());
+
+    const int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        throw shm_error("shm_open", this->name);
+
+    if (ftruncate(fd, off_t(size)) != 0) {
+        const std::runtime_error error = shm_error("ftruncate", this->name);
+        close(fd);
+        shm_unlink(this->name.c_str());
+        throw error;
+    }
+
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping keeps the object alive, the descriptor isnt needed anymore
+    close(fd);
+    if (memory == MAP_FAILED) {
+        memory = nullptr;
+        shm_unlink(this->name.c_str());
+        throw shm_error("mmap", this->name);
+    }
+
+    // ftruncate zero fills, so every sequence starts even and latest at 0
+    uint8_t* base = static_cast<uint8_t*>(memory);
+    for (uint32_t i = 0; i < slot_count; ++i)
+        new (base + frame_header_size + slot_stride * i) FrameSlotHeader{};
+
+    header = new (memory) FrameRingHeader{};
+    header->slot_count = slot_count;
+    header->format = SDL_PIXELFORMAT_ARGB8888;
+    header->width = width;
+    header->height = height;
+    header->pitch = pitch;
+    header->slot_stride = slot_stride;
+    header->version = frame_ring_version;
+    // written last, a reader that sees the magic sees everything else
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = frame_ring_magic;
+}
+
+FrameOutput::~FrameOutput() {
+    if (memory)
+        munmap(memory, size);
+    // readers that still have it mapped keep their mapping, new ones just wont find it
+    shm_unlink(name.c_str());
+}
+
+FrameSlotHeader& FrameOutput::begin_frame(uint8_t*& pixels) {
+    ++frame;
+    uint8_t* slot = static_cast<uint8_t*>(memory) + frame_header_size + header->slot_stride * ((frame - 1) % header->slot_count);
+    pixels = slot + frame_header_size;
+
+    FrameSlotHeader& slot_header = *reinterpret_cast<FrameSlotHeader*>(slot);
+    const uint64_t sequence = slot_header.sequence.load(std::memory_order_relaxed);
+    slot_header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    // keeps the pixel writes below from moving above the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot_header;
+}
+
+void FrameOutput::end_frame(FrameSlotHeader& slot, int width, int height) {
+    slot.frame = frame;
+    slot.timestamp = SDL_GetTicks();
+    slot.width = width;
+    slot.height = height;
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    header->latest.store(frame, std::memory_order_release);
+}
+
+bool FrameOutput::publish(SDL_Renderer* renderer) {
+    int width = 0, height = 0;
+    if (SDL_GetRendererOutputSize(renderer, &width, &height) != 0)
+        return false;
+
+    const SDL_Rect area = { 0, 0, std::min(width, header->width), std::min(height, header->height) };
+
+    uint8_t* pixels;
+    FrameSlotHeader& slot = begin_frame(pixels);
+    // straight from the renderer into shared memory, this is the only copy the frame goes through
+    const bool ok = SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, pixels, header->pitch) == 0;
+    // a failed read still has to leave the sequence even, it just reports an empty frame
+    end_frame(slot, ok ? area.w : 0, ok ? area.h : 0);
+
+    if (!ok)
+        SDL_Log("SDL2 Error: %s", SDL_GetError());
+    return ok;
+}
+
+bool FrameOutput::publish(const void* pixels, int pitch, int width, int height) {
+    if (pixels == nullptr)
+        return false;
+
+    width = std::min(width, header->width);
+    height = std::min(height, header->height);
+
+    uint8_t* out;
+    FrameSlotHeader& slot = begin_frame(out);
+    for (int y = 0; y < height; ++y)
+        std::memcpy(out + size_t(y) * header->pitch, static_cast<const uint8_t*>(pixels) + size_t(y) * pitch, size_t(width) * 4);
+    end_frame(slot, width, height);
+    return true;
+}
+
+const std::string& FrameOutput::get_name() const {
+    return name;
+}
+
+uint64_t FrameOutput::get_frames_published() const {
+    return frame;
+}
+
+FrameReader::FrameReader(std::string name) {
+    name = shm_name(std::move(name));
+
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw shm_error("shm_open", name);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < frame_header_size) {
+        close(fd);
+        throw std::runtime_error(name + " is not a frame ring");
+    }
+    size = size_t(info.st_size);
+
+    memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        memory = nullptr;
+        throw shm_error("mmap", name);
+    }
+
+    header = static_cast<const FrameRingHeader*>(memory);
+    const bool valid = header->magic == frame_ring_magic && header->version == frame_ring_version
+        && header->slot_count > 0 && frame_header_size + header->slot_stride * header->slot_count <= size;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid) {
+        munmap(memory, size);
+        memory = nullptr;
+        throw std::runtime_error(name + " is not a frame ring");
+    }
+}
+
+FrameReader::~FrameReader() {
+    if (memory)
+        munmap(memory, size);
+}
+
+bool FrameReader::next(Frame& out) {
+    const uint64_t latest = header->latest.load(std::memory_order_acquire);
+    if (latest == 0 || latest == last)
+        return false;
+
+    const uint8_t* slot = static_cast<const uint8_t*>(memory) + frame_header_size + header->slot_stride * ((latest - 1) % header->slot_count);
+    const FrameSlotHeader& slot_header = *reinterpret_cast<const FrameSlotHeader*>(slot);
+
+    const uint64_t sequence = slot_header.sequence.load(std::memory_order_acquire);
+    // odd means the writer lapped the ring and is in this slot again, a later call gets the newer frame
+    if (sequence & 1)
+        return false;
+
+    out = { slot + frame_header_size, slot_header.width, slot_header.height, header->pitch, header->format,
+        slot_header.frame, slot_header.timestamp, sequence, &slot_header };
+
+    // the fields above could belong to a newer frame if the writer got in between
+    if (!still_valid(out) || out.index != latest)
+        return false;
+
+    last = latest;
+    return true;
+}
+
+bool FrameReader::still_valid(const Frame& frame) {
+    // orders the reads of the pixels before the sequence check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frame.slot->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
+
+const FrameRingHeader& FrameReader::get_header() const {
+    return *header;
+}
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+// publishes finished frames into a POSIX shared memory ring so another local process (an encoder, a preview)
+// can read them straight out of the mapping, no files, no copies on the reading side and no syscalls per frame
+// only available where shm_open is, SDLPP_HAS_FRAME_OUTPUT tells if it is, Window only publishes when built with SDLPP_FRAME_OUTPUT
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__ANDROID__)
+#define SDLPP_HAS_FRAME_OUTPUT 1
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// the layout of the shared memory, for consumers not written against FrameReader
+//
+//  offset 0                     FrameRingHeader
+//  frame_header_size            slot 0: FrameSlotHeader, pixels start frame_header_size into the slot
+//  + slot_stride * i            slot i
+//
+// a slot is written under a seqlock, sequence is odd while the writer is in it and goes up by 2 for every frame,
+// read sequence, use the pixels, then read it again, if it changed or was odd the pixels were being overwritten
+// frame n always lands in slot (n - 1) % slot_count, so a slot is only reused after slot_count - 1 newer frames
+constexpr uint32_t frame_ring_magic = 0x4d524653; // "SFRM"
+constexpr uint32_t frame_ring_version = 1;
+constexpr size_t frame_header_size = 64;
+
+struct FrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    // an SDL_PixelFormatEnum, always SDL_PIXELFORMAT_ARGB8888 for now
+    uint32_t format;
+    // the largest frame a slot holds, pitch is width * 4
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+    uint32_t reserved;
+    uint64_t slot_stride;
+    // index of the newest complete frame, 0 before the first one, indices start at 1
+    std::atomic<uint64_t> latest;
+};
+
+struct FrameSlotHeader {
+    std::atomic<uint64_t> sequence;
+    uint64_t frame;
+    // SDL_GetTicks() when the frame was written
+    uint64_t timestamp;
+    // the part of the slot this frame filled, smaller than the ring when the window is smaller
+    int32_t width;
+    int32_t height;
+};
+
+static_assert(sizeof(FrameRingHeader) <= frame_header_size && sizeof(FrameSlotHeader) <= frame_header_size);
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock has to work across processes");
+
+class FrameOutput {
+public:
+    // creates the shared memory object name (a leading / is added if missing), replacing one left behind by an
+    // earlier run, sized for width x height frames, throws std::runtime_error when it cant be created
+    FrameOutput(std::string name, int width, int height, uint32_t slot_count = 3);
+    ~FrameOutput();
+    FrameOutput(const FrameOutput&) = delete;
+    FrameOutput& operator=(const FrameOutput&) = delete;
+
+    // reads the current render target into the next slot, has to happen before SDL_RenderPresent
+    // Window::display does this for you once set_frame_output is called
+    // the window is cut to the ring size if it got bigger, returns false if the read back failed
+    bool publish(SDL_Renderer* renderer);
+    // for frames that didnt come from a renderer, pixels have to be ARGB8888
+    bool publish(const void* pixels, int pitch, int width, int height);
+
+    const std::string& get_name() const;
+    uint64_t get_frames_published() const;
+
+private:
+    FrameSlotHeader& begin_frame(uint8_t*& pixels);
+    void end_frame(FrameSlotHeader& slot, int width, int height);
+
+    std::string name;
+    void* memory = nullptr;
+    size_t size = 0;
+    FrameRingHeader* header = nullptr;
+    uint64_t frame = 0;
+};
+
+// the consuming side, maps the ring read only and hands out pointers straight into it
+class FrameReader {
+public:
+    struct Frame {
+        const uint8_t* pixels;
+        int width;
+        int height;
+        int pitch;
+        uint32_t format;
+        uint64_t index;
+        uint64_t timestamp;
+        // what still_valid compares against
+        uint64_t sequence;
+        const FrameSlotHeader* slot;
+    };
+
+    // throws std::runtime_error if the ring doesnt exist or isnt one
+    explicit FrameReader(std::string name);
+    ~FrameReader();
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    // the newest frame if it wasnt handed out before, false if there is none or the writer is in its slot right now
+    bool next(Frame& out);
+    // true if nothing overwrote the frame since next returned it, check after using the pixels and drop the result if not
+    static bool still_valid(const Frame& frame);
+
+    const FrameRingHeader& get_header() const;
+
+private:
+    void* memory = nullptr;
+    size_t size = 0;
+    const FrameRingHeader* header = nullptr;
+    uint64_t last = 0;
+};
+
+#endif
@@ -2,6 +2,8 @@
 #include "inputs.hpp"
 #include <algorithm>
 
+#include "trace.hpp"
+
 namespace Shakkar {
 
     void inputs::updateMousePos(int32_t x, int32_t y, int32_t dx, int32_t dy) {
@@ -11,29 +13,30 @@ namespace Shakkar {
         mouse.dy = dy;
     }
 
+    // adds up like dx and dy, so several wheel events in one frame all count, update() resets it
     void inputs::updateMouseWheel(int32_t wx, int32_t wy, int32_t dwx) {
-        mouse.wx = wx;
-        mouse.wy = wy;
-
         if (dwx == SDL_MOUSEWHEEL_FLIPPED) {
-            mouse.wx = -wx;
-            mouse.wy = -wy;
+            wx = -wx;
+            wy = -wy;
         }
+        mouse.wx += wx;
+        mouse.wy += wy;
     }
 
+    // pressed stays set until the next update(), so a click released within the same frame isnt lost
     void inputs::updateMouseButtons(uint32_t which, bool state) {
         switch (which) {
         case SDL_BUTTON_LEFT:
             mouse.left_held = state;
-            mouse.left_pressed = state;
+            mouse.left_pressed |= state;
             break;
         case SDL_BUTTON_RIGHT:
             mouse.right_held = state;
-            mouse.right_pressed = state;
+            mouse.right_pressed |= state;
             break;
         case SDL_BUTTON_MIDDLE:
             mouse.middle_held = state;
-            mouse.middle_pressed = state;
+            mouse.middle_pressed |= state;
             break;
         default:
             break;
@@ -44,12 +47,27 @@ namespace Shakkar {
         dropped_file = file;
     }
 
+    // true if key wasnt in the sorted keys yet
+    static bool insertKey(std::vector<SDL_Keycode>& keys, SDL_Keycode key) {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        if (it != keys.end() && *it == key)
+            return false;
+        keys.insert(it, key);
+        return true;
+    }
+
+    // like the mouse buttons pressed and released stay set until the next update(), so a tap within one frame isnt lost
     void inputs::addKey(SDL_Keycode key) {
-        cur_buttons.insert(key);
+        if (insertKey(cur_buttons, key))
+            insertKey(pressed_buttons, key);
     }
 
     void inputs::removeKey(SDL_Keycode key) {
-        cur_buttons.erase(key);
+        auto it = std::lower_bound(cur_buttons.begin(), cur_buttons.end(), key);
+        if (it != cur_buttons.end() && *it == key) {
+            cur_buttons.erase(it);
+            insertKey(released_buttons, key);
+        }
     }
 
     Mouse inputs::getMouse() const {
@@ -59,23 +77,61 @@ namespace Shakkar {
     Key inputs::getKey(SDL_Keycode key) const {
         Key keyState{};
 
-        auto cur = std::find(cur_buttons.begin(), cur_buttons.end(), key) != cur_buttons.end();
+        auto cur = std::binary_search(cur_buttons.begin(), cur_buttons.end(), key);
 
-        auto prev = std::find(prev_buttons.begin(), prev_buttons.end(), key) != prev_buttons.end();
+        auto prev = std::binary_search(prev_buttons.begin(), prev_buttons.end(), key);
 
         keyState.held = cur && prev;
-        keyState.pressed = justPressed(prev, cur);
-        keyState.released = !cur && prev;
+        keyState.pressed = justPressed(prev, cur) || std::binary_search(pressed_buttons.begin(), pressed_buttons.end(), key);
+        keyState.released = (!cur && prev) || std::binary_search(released_buttons.begin(), released_buttons.end(), key);
 
         return keyState;
     }
 
-    std::string inputs::getDroppedFile() const {
+    const std::string& inputs::getDroppedFile() const {
         return dropped_file;
     }
 
+    void inputs::attach(EventPump* pump, bool keep_history) {
+        this->pump = pump;
+        this->keep_history = keep_history;
+        events.clear();
+    }
+
+    const std::vector<InputEvent>& inputs::getEvents() const {
+        return events;
+    }
+
+    void inputs::apply(const InputEvent& event) {
+        switch (event.type) {
+        case InputEvent::Type::KeyDown:
+            addKey(event.key);
+            break;
+        case InputEvent::Type::KeyUp:
+            removeKey(event.key);
+            break;
+        case InputEvent::Type::MouseMotion:
+            // sub frame motion adds up instead of only the last event counting
+            mouse.x = event.x;
+            mouse.y = event.y;
+            mouse.dx += event.dx;
+            mouse.dy += event.dy;
+            break;
+        case InputEvent::Type::MouseButton:
+            updateMouseButtons(event.which, event.state);
+            break;
+        case InputEvent::Type::MouseWheel:
+            updateMouseWheel(event.x, event.y, event.which);
+            break;
+        }
+    }
+
     void inputs::update() {
+        SDLPP_TRACE_SCOPE("inputs::update");
+
         prev_buttons = cur_buttons;
+        pressed_buttons.clear();
+        released_buttons.clear();
 
         mouse.dx = 0;
         mouse.dy = 0;
@@ -87,6 +143,159 @@ namespace Shakkar {
         mouse.right_pressed = false;
         mouse.middle_pressed = false;
 
-        dropped_file = "";
+        // clear keeps the capacity around for the next dropped file
+        dropped_file.clear();
+
+        if (pump) {
+            events.clear();
+
+            InputEvent event;
+            while (pump->queue().pop(event)) {
+                apply(event);
+                if (keep_history)
+                    events.push_back(event);
+            }
+        }
+    }
+
+    EventPump::~EventPump() {
+        stop();
+    }
+
+    void EventPump::start() {
+        if (running.exchange(true))
+            return;
+
+        thread = std::thread(&EventPump::run, this);
+    }
+
+    void EventPump::stop() {
+        running.store(false);
+        if (thread.joinable())
+            thread.join();
+    }
+
+    void EventPump::push(const SDL_Event& event, uint64_t counter) {
+        InputEvent out{};
+        out.timestamp = event.common.timestamp;
+        out.counter = counter;
+
+        switch (event.type) {
+        case SDL_KEYDOWN:
+            // held keys repeat, only the first press changes anything
+            if (event.key.repeat)
+                return;
+            out.type = InputEvent::Type::KeyDown;
+            out.key = event.key.keysym.sym;
+            break;
+        case SDL_KEYUP:
+            out.type = InputEvent::Type::KeyUp;
+            out.key = event.key.keysym.sym;
+            break;
+        case SDL_MOUSEMOTION:
+            out.type = InputEvent::Type::MouseMotion;
+            out.x = event.motion.x;
+            out.y = event.motion.y;
+            out.dx = event.motion.xrel;
+            out.dy = event.motion.yrel;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            out.type = InputEvent::Type::MouseButton;
+            out.x = event.button.x;
+            out.y = event.button.y;
+            out.which = event.button.button;
+            out.state = event.button.state == SDL_PRESSED;
+            break;
+        case SDL_MOUSEWHEEL:
+            out.type = InputEvent::Type::MouseWheel;
+            out.x = event.wheel.x;
+            out.y = event.wheel.y;
+            out.which = event.wheel.direction;
+            break;
+        default:
+            return;
+        }
+
+        if (!ring.push(out)) {
+            dropped_events.fetch_add(1, std::memory_order_relaxed);
+            SDLPP_TRACE_INSTANT("EventPump dropped an event");
+        }
+    }
+
+    void EventPump::run() {
+        constexpr int batch_size = 64;
+        SDL_Event keys[batch_size];
+        SDL_Event mice[batch_size];
+        int key_count = 0;
+        int mouse_count = 0;
+
+        while (running.load(std::memory_order_relaxed)) {
+            // only the keyboard and mouse ranges are taken, everything else stays queued for the main thread
+            const int new_keys = SDL_PeepEvents(keys + key_count, batch_size - key_count, SDL_GETEVENT, SDL_KEYDOWN, SDL_KEYUP);
+            const int new_mice = SDL_PeepEvents(mice + mouse_count, batch_size - mouse_count, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEWHEEL);
+            key_count += std::max(new_keys, 0);
+            mouse_count += std::max(new_mice, 0);
+            const uint64_t counter = SDL_GetPerformanceCounter();
+
+            // the two ranges come out separately, merging them by timestamp puts keys and mouse back in the order
+            // they happened, a full batch can have older events still queued behind it than the other one has,
+            // so nothing past the end of a full batch goes out until the next round
+            uint32_t limit = UINT32_MAX;
+            if (key_count == batch_size)
+                limit = std::min(limit, keys[key_count - 1].common.timestamp);
+            if (mouse_count == batch_size)
+                limit = std::min(limit, mice[mouse_count - 1].common.timestamp);
+
+            int k = 0, m = 0;
+            while (k < key_count || m < mouse_count) {
+                // on equal timestamps the key goes first, SDL timestamps are only milliseconds
+                const bool take_key = m == mouse_count || (k < key_count && keys[k].common.timestamp <= mice[m].common.timestamp);
+                const SDL_Event& event = take_key ? keys[k] : mice[m];
+                if (event.common.timestamp > limit)
+                    break;
+
+                push(event, counter);
+                take_key ? ++k : ++m;
+            }
+
+            std::copy(keys + k, keys + key_count, keys);
+            std::copy(mice + m, mice + mouse_count, mice);
+            key_count -= k;
+            mouse_count -= m;
+
+            if (new_keys <= 0 && new_mice <= 0)
+                SDL_Delay(1);
+        }
+    }
+
+    bool EventPump::pollEvent(SDL_Event& event) {
+        // everything around the keyboard (SDL_KEYDOWN, SDL_KEYUP) and mouse (SDL_MOUSEMOTION to SDL_MOUSEWHEEL) ranges
+        static constexpr Uint32 ranges[3][2] = {
+            { SDL_FIRSTEVENT, SDL_KEYDOWN - 1 },
+            { SDL_KEYUP + 1, SDL_MOUSEMOTION - 1 },
+            { SDL_MOUSEWHEEL + 1, SDL_LASTEVENT },
+        };
+
+        // only pumps once the queue has nothing left for us, like SDL_PollEvent does per call but cheaper
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            int oldest = -1;
+            uint32_t oldest_timestamp = 0;
+            for (int i = 0; i < 3; ++i) {
+                SDL_Event peeked;
+                if (SDL_PeepEvents(&peeked, 1, SDL_PEEKEVENT, ranges[i][0], ranges[i][1]) == 1
+                    && (oldest < 0 || peeked.common.timestamp < oldest_timestamp)) {
+                    oldest = i;
+                    oldest_timestamp = peeked.common.timestamp;
+                }
+            }
+
+            if (oldest >= 0)
+                return SDL_PeepEvents(&event, 1, SDL_GETEVENT, ranges[oldest][0], ranges[oldest][1]) == 1;
+
+            if (attempt == 0)
+                SDL_PumpEvents();
+        }
+        return false;
     }
 };
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 #include <SDL2/SDL.h>
 
-#include <set>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace Shakkar {
     // taken inspiration from the PixelGameEngine HWButton struct by javidx9
@@ -31,6 +35,100 @@ namespace Shakkar {
         bool middle_pressed;
     };
 
+    // an input event taken off the SDL queue by the EventPump
+    struct InputEvent {
+        enum class Type : uint8_t {
+            KeyDown,
+            KeyUp,
+            MouseMotion,
+            MouseButton,
+            MouseWheel,
+        };
+
+        Type type;
+        // SDL_GetTicks() of when SDL queued the event
+        uint32_t timestamp;
+        // SDL_GetPerformanceCounter() of when the pump took it off the queue
+        uint64_t counter;
+
+        SDL_Keycode key;
+        // mouse position for motion, wheel amount for wheel
+        int32_t x;
+        int32_t y;
+        int32_t dx;
+        int32_t dy;
+        // mouse button, or wheel direction
+        uint32_t which;
+        bool state;
+    };
+
+    // lock free single producer single consumer ring, N has to be a power of two
+    template <typename T, size_t N>
+    class SpscRing {
+        static_assert((N & (N - 1)) == 0, "SpscRing size has to be a power of two");
+    public:
+        // producer side, returns false when full
+        bool push(const T& item) {
+            const size_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == N)
+                return false;
+
+            items[h & (N - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side, returns false when empty
+        bool pop(T& item) {
+            const size_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire))
+                return false;
+
+            item = items[t & (N - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        // kept on separate cache lines so the two threads dont fight over them
+        alignas(64) std::atomic<size_t> head{ 0 };
+        alignas(64) std::atomic<size_t> tail{ 0 };
+        T items[N];
+    };
+
+    // drains keyboard and mouse events from SDL on its own thread into a ring that inputs::update() consumes
+    // SDL only fills its queue when the main thread pumps, so while a pump runs the main thread should loop over
+    // EventPump::pollEvent instead of SDL_PollEvent, SDL_PollEvent would take input events too and a key
+    // could be released through one path before the ring delivers its press
+    class EventPump {
+    public:
+        using Queue = SpscRing<InputEvent, 4096>;
+
+        EventPump() = default;
+        EventPump(const EventPump&) = delete;
+        EventPump& operator=(const EventPump&) = delete;
+        ~EventPump();
+
+        void start();
+        void stop();
+
+        // SDL_PollEvent for the main thread, pumps SDL and hands out everything except the keyboard and mouse events
+        static bool pollEvent(SDL_Event& event);
+
+        Queue& queue() { return ring; }
+        // events lost because the ring was full
+        size_t dropped() const { return dropped_events.load(std::memory_order_relaxed); }
+
+    private:
+        void run();
+        void push(const SDL_Event& event, uint64_t counter);
+
+        std::thread thread;
+        std::atomic<bool> running{ false };
+        std::atomic<size_t> dropped_events{ 0 };
+        Queue ring;
+    };
+
     class inputs {
     public:
         void updateMousePos(int32_t x, int32_t y, int32_t dx, int32_t dy);
@@ -42,11 +140,27 @@ namespace Shakkar {
 
         Mouse getMouse() const;
         Key getKey(SDL_Keycode key) const;
-        std::string getDroppedFile() const;
+        const std::string& getDroppedFile() const;
+
+        // from now on update() also applies everything the pump queued since the last update
+        // with keep_history every event of the frame is kept for getEvents(), otherwise mouse motion is only merged into dx/dy
+        void attach(EventPump* pump, bool keep_history = false);
+        const std::vector<InputEvent>& getEvents() const;
+
         void update();
     private:
-        std::set<SDL_Keycode> cur_buttons;
-        std::set<SDL_Keycode> prev_buttons;
+        void apply(const InputEvent& event);
+
+        EventPump* pump = nullptr;
+        bool keep_history = false;
+        std::vector<InputEvent> events;
+
+        // kept sorted, vectors so copying cur into prev every update reuses the capacity instead of allocating nodes
+        std::vector<SDL_Keycode> cur_buttons;
+        std::vector<SDL_Keycode> prev_buttons;
+        // every key that went down or up since the last update, so a tap within one frame still shows up like a click does
+        std::vector<SDL_Keycode> pressed_buttons;
+        std::vector<SDL_Keycode> released_buttons;
         std::string dropped_file;
         Mouse mouse{};
     };
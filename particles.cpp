@@ -0,0 +1,177 @@
+#include "particles.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define SDLPP_PARTICLES_SSE2
+#include <emmintrin.h>
+#endif
+
+static size_t roundUp4(size_t n) {
+	return (n + 3) & ~size_t(3);
+}
+
+ParticleEmitter::ParticleEmitter(Window& window, std::string_view path, size_t capacity) :
+	ParticleEmitter(capacity) {
+	handle = TextureDictionary::acquire(window, TextureDictionary::intern(path));
+}
+
+ParticleEmitter::ParticleEmitter(size_t capacity) :
+	capacity(capacity) {
+
+	const size_t padded = roundUp4(capacity);
+	posX.resize(padded);
+	posY.resize(padded);
+	velX.resize(padded);
+	velY.resize(padded);
+	life.resize(padded);
+	invMaxLife.resize(padded);
+	color.resize(padded);
+
+	// the index pattern never changes, so it is built once for every quad the pool can hold
+	vertices.resize(capacity * 4);
+	indices.resize(capacity * 6);
+	for (size_t i = 0; i < capacity; ++i) {
+		const int v = int(i * 4);
+		int* quad = &indices[i * 6];
+		quad[0] = v; quad[1] = v + 1; quad[2] = v + 2;
+		quad[3] = v + 2; quad[4] = v + 3; quad[5] = v;
+	}
+}
+
+// xorshift32, good enough for spawning and doesnt touch any global state
+float ParticleEmitter::random01() {
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return (rngState >> 8) * (1.f / 16777216.f);
+}
+
+void ParticleEmitter::emit(size_t n) {
+	n = std::min(n, capacity - count);
+
+	for (size_t i = count; i < count + n; ++i) {
+		const float a = settings.angle + (random01() * 2.f - 1.f) * settings.angleSpread;
+		const float speed = settings.minSpeed + random01() * (settings.maxSpeed - settings.minSpeed);
+		const float lifetime = std::max(settings.minLife + random01() * (settings.maxLife - settings.minLife), 1e-3f);
+
+		posX[i] = settings.x + (random01() * 2.f - 1.f) * settings.spread;
+		posY[i] = settings.y + (random01() * 2.f - 1.f) * settings.spread;
+		velX[i] = std::cos(a) * speed;
+		velY[i] = std::sin(a) * speed;
+		life[i] = lifetime;
+		invMaxLife[i] = 1.f / lifetime;
+		color[i] = settings.color;
+	}
+	count += n;
+}
+
+void ParticleEmitter::update(float dt) {
+	integrate(dt);
+	compact();
+
+	if (settings.rate > 0.f) {
+		spawnAccumulator += settings.rate * dt;
+		const size_t spawn = size_t(spawnAccumulator);
+		spawnAccumulator -= float(spawn);
+		emit(spawn);
+	}
+}
+
+void ParticleEmitter::integrate(float dt) {
+	const size_t n = roundUp4(count);
+	const float gx = settings.gravityX * dt;
+	const float gy = settings.gravityY * dt;
+
+#ifdef SDLPP_PARTICLES_SSE2
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 vgx = _mm_set1_ps(gx);
+	const __m128 vgy = _mm_set1_ps(gy);
+
+	for (size_t i = 0; i < n; i += 4) {
+		__m128 vx = _mm_add_ps(_mm_loadu_ps(&velX[i]), vgx);
+		__m128 vy = _mm_add_ps(_mm_loadu_ps(&velY[i]), vgy);
+		_mm_storeu_ps(&velX[i], vx);
+		_mm_storeu_ps(&velY[i], vy);
+		_mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, vdt)));
+		_mm_storeu_ps(&posY[i], _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, vdt)));
+		_mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), vdt));
+	}
+#else
+	// plain loops over the separate arrays, which compilers auto vectorize
+	for (size_t i = 0; i < n; ++i) {
+		velX[i] += gx;
+		velY[i] += gy;
+		posX[i] += velX[i] * dt;
+		posY[i] += velY[i] * dt;
+		life[i] -= dt;
+	}
+#endif
+}
+
+// removes dead particles by moving the last live one into their place, order isnt preserved
+void ParticleEmitter::compact() {
+	size_t i = 0;
+	while (i < count) {
+		if (life[i] > 0.f) {
+			++i;
+			continue;
+		}
+
+		--count;
+		posX[i] = posX[count];
+		posY[i] = posY[count];
+		velX[i] = velX[count];
+		velY[i] = velY[count];
+		life[i] = life[count];
+		invMaxLife[i] = invMaxLife[count];
+		color[i] = color[count];
+	}
+}
+
+void ParticleEmitter::render(Window& window) {
+	if (count == 0)
+		return;
+
+	SDL_Texture* texture = nullptr;
+	if (handle.index != UINT32_MAX) {
+		Texture* tex = TextureDictionary::get(handle);
+		[[unlikely]] if (tex == nullptr) {
+			// the texture was released from the dictionary, we have nothing to draw with
+			return;
+		}
+		texture = tex->texture;
+	}
+
+	// a premultiplied texture adds whatever colour is left, so fading only alpha would brighten dying particles
+	SDL_BlendMode mode = SDL_BLENDMODE_BLEND;
+	const bool premultiplied = texture && SDL_GetTextureBlendMode(texture, &mode) == 0 && mode == premultipliedBlendMode();
+
+	window.render_geometry(texture, buildVertices(premultiplied), int(count * 4), indices.data(), int(count * 6));
+}
+
+const SDL_Vertex* ParticleEmitter::buildVertices(bool premultiplied) {
+	const float half = settings.size * 0.5f;
+
+	for (size_t i = 0; i < count; ++i) {
+		SDL_Color c = color[i];
+		c.a = Uint8(c.a * std::clamp(life[i] * invMaxLife[i], 0.f, 1.f));
+		if (premultiplied) {
+			const float alpha = c.a * (1.f / 255.f);
+			c.r = Uint8(c.r * alpha);
+			c.g = Uint8(c.g * alpha);
+			c.b = Uint8(c.b * alpha);
+		}
+
+		const float x = posX[i];
+		const float y = posY[i];
+
+		SDL_Vertex* quad = &vertices[i * 4];
+		quad[0] = { { x - half, y - half }, c, { 0.f, 0.f } };
+		quad[1] = { { x + half, y - half }, c, { 1.f, 0.f } };
+		quad[2] = { { x + half, y + half }, c, { 1.f, 1.f } };
+		quad[3] = { { x - half, y + half }, c, { 0.f, 1.f } };
+	}
+	return vertices.data();
+}
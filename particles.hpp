@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "../SDLpp/Window.hpp"
+#include "texture.hpp"
+
+// how new particles get spawned, angles are in radians and speeds in pixels per second
+struct EmitterSettings {
+	float x = 0.f;
+	float y = 0.f;
+	// particles spawn somewhere in a square of this half size around x, y
+	float spread = 0.f;
+
+	float angle = 0.f;
+	float angleSpread = 3.14159265f;
+	float minSpeed = 50.f;
+	float maxSpeed = 100.f;
+
+	float gravityX = 0.f;
+	float gravityY = 0.f;
+
+	float minLife = 1.f;
+	float maxLife = 2.f;
+
+	// width and height of the quad every particle is drawn with
+	float size = 4.f;
+	SDL_Color color = { 255, 255, 255, 255 };
+
+	// particles per second spawned by update(), 0 means only emit() spawns
+	float rate = 0.f;
+};
+
+// a fixed capacity particle pool, stored as structure of arrays so update() can run 4 particles at a time
+// every live particle is drawn with a single SDL_RenderGeometry call using the emitters texture
+class ParticleEmitter {
+public:
+	ParticleEmitter(Window& window, std::string_view path, size_t capacity);
+	// untextured, the quads are drawn in their colour only, also needs no window so it runs headless
+	explicit ParticleEmitter(size_t capacity);
+
+	// spawns up to count particles, anything past the capacity is dropped
+	void emit(size_t count);
+	void update(float dt);
+	void render(Window& window);
+	// fills in the quads of the live particles, size() * 4 of them, render() does this before drawing
+	// premultiplied scales the colours by the fade as well, for textures drawn with premultipliedBlendMode()
+	const SDL_Vertex* buildVertices(bool premultiplied = false);
+	void clear() { count = 0; }
+
+	size_t size() const { return count; }
+	size_t getCapacity() const { return capacity; }
+
+	EmitterSettings settings;
+
+private:
+	float random01();
+	void integrate(float dt);
+	void compact();
+
+	// stays invalid for untextured emitters
+	TextureHandle handle;
+
+	size_t capacity = 0;
+	size_t count = 0;
+	float spawnAccumulator = 0.f;
+	uint32_t rngState = 0x9E3779B9u;
+
+	// all of these are padded to a multiple of 4 so the update loop never needs a scalar tail
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> velX;
+	std::vector<float> velY;
+	std::vector<float> life;
+	std::vector<float> invMaxLife;
+	std::vector<SDL_Color> color;
+
+	// reused every frame, sized once for the full capacity
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+};
@@ -0,0 +1,182 @@
+#include "picking.hpp"
+
+#include <algorithm>
+
+HitTester::HitTester(int cell_size) : cell_size(std::max(cell_size, 1)) {}
+
+void HitTester::set_logical_space(SDL_Rect parent, float sim_width, float sim_height) {
+    this->has_logical_space = true;
+    this->parent = parent;
+    this->sim_width = sim_width;
+    this->sim_height = sim_height;
+
+    // every screen rect changes with the mapping, so the grid is rebuilt from scratch
+    for (auto& [key, ids] : cells)
+        ids.clear();
+
+    for (Id id = 0; id < objects.size(); ++id) {
+        Object& object = objects[id];
+        if (!object.alive)
+            continue;
+
+        object.screen = to_screen(object.logical);
+        link(id, cells_of(object.screen));
+    }
+}
+
+SDL_Rect HitTester::to_screen(SDL_Rect logical) const {
+    if (!has_logical_space)
+        return logical;
+    return Window::calculate_logical_rect(parent, logical, sim_width, sim_height);
+}
+
+// cells are [cx * cell_size, (cx + 1) * cell_size), floor division keeps negative coordinates in the right cell
+HitTester::CellRange HitTester::cells_of(SDL_Rect rect) const {
+    auto cell = [this](int32_t v) { return v >= 0 ? v / cell_size : -((-v + cell_size - 1) / cell_size); };
+
+    const int32_t w = std::max(rect.w, 1);
+    const int32_t h = std::max(rect.h, 1);
+    return { cell(rect.x), cell(rect.y), cell(rect.x + w - 1), cell(rect.y + h - 1) };
+}
+
+uint64_t HitTester::cell_key(int32_t cx, int32_t cy) {
+    return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+}
+
+void HitTester::link(Id id, CellRange range) {
+    for (int32_t cy = range.y0; cy <= range.y1; ++cy)
+        for (int32_t cx = range.x0; cx <= range.x1; ++cx)
+            cells[cell_key(cx, cy)].push_back(id);
+}
+
+void HitTester::unlink(Id id, CellRange range) {
+    for (int32_t cy = range.y0; cy <= range.y1; ++cy) {
+        for (int32_t cx = range.x0; cx <= range.x1; ++cx) {
+            auto it = cells.find(cell_key(cx, cy));
+            if (it == cells.end())
+                continue;
+
+            std::vector<Id>& ids = it->second;
+            auto found = std::find(ids.begin(), ids.end(), id);
+            if (found != ids.end()) {
+                *found = ids.back();
+                ids.pop_back();
+            }
+        }
+    }
+}
+
+HitTester::Id HitTester::insert(SDL_Rect rect, int32_t z) {
+    Id id;
+    if (!free_ids.empty()) {
+        id = free_ids.back();
+        free_ids.pop_back();
+    } else {
+        id = Id(objects.size());
+        objects.emplace_back();
+    }
+
+    Object& object = objects[id];
+    object = { rect, to_screen(rect), z, next_sequence++, query_stamp, true };
+    link(id, cells_of(object.screen));
+
+    ++live;
+    return id;
+}
+
+void HitTester::move(Id id, SDL_Rect rect) {
+    Object& object = objects.at(id);
+    if (!object.alive)
+        return;
+
+    const SDL_Rect screen = to_screen(rect);
+    const CellRange before = cells_of(object.screen);
+    const CellRange after = cells_of(screen);
+
+    // small moves usually stay inside the same cells, then only the rect changes
+    if (!(before == after)) {
+        unlink(id, before);
+        link(id, after);
+    }
+
+    object.logical = rect;
+    object.screen = screen;
+}
+
+void HitTester::set_z(Id id, int32_t z) {
+    objects.at(id).z = z;
+}
+
+void HitTester::remove(Id id) {
+    Object& object = objects.at(id);
+    if (!object.alive)
+        return;
+
+    unlink(id, cells_of(object.screen));
+    object.alive = false;
+    free_ids.push_back(id);
+    --live;
+}
+
+void HitTester::clear() {
+    for (auto& [key, ids] : cells)
+        ids.clear();
+
+    objects.clear();
+    free_ids.clear();
+    live = 0;
+}
+
+HitTester::Id HitTester::pick(int32_t x, int32_t y) {
+    const CellRange range = cells_of({ x, y, 1, 1 });
+    auto it = cells.find(cell_key(range.x0, range.y0));
+    if (it == cells.end())
+        return none;
+
+    const SDL_Point point = { x, y };
+    Id best = none;
+
+    for (Id id : it->second) {
+        const Object& object = objects[id];
+        if (!SDL_PointInRect(&point, &object.screen))
+            continue;
+
+        if (best == none || object.z > objects[best].z || (object.z == objects[best].z && object.sequence > objects[best].sequence))
+            best = id;
+    }
+    return best;
+}
+
+void HitTester::query(SDL_Rect area, std::vector<Id>& out) {
+    if (area.w <= 0 || area.h <= 0)
+        return;
+
+    ++query_stamp;
+    const CellRange range = cells_of(area);
+
+    for (int32_t cy = range.y0; cy <= range.y1; ++cy) {
+        for (int32_t cx = range.x0; cx <= range.x1; ++cx) {
+            auto it = cells.find(cell_key(cx, cy));
+            if (it == cells.end())
+                continue;
+
+            for (Id id : it->second) {
+                Object& object = objects[id];
+                if (object.stamp == query_stamp)
+                    continue;
+
+                object.stamp = query_stamp;
+                if (SDL_HasIntersection(&object.screen, &area))
+                    out.push_back(id);
+            }
+        }
+    }
+}
+
+SDL_Rect HitTester::get_screen_rect(Id id) const {
+    return objects.at(id).screen;
+}
+
+size_t HitTester::size() const {
+    return live;
+}
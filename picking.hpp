@@ -0,0 +1,76 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../SDLpp/Window.hpp"
+
+// spatial hash over rects for answering "what is under the cursor" and "what is inside this box"
+// without looking at every object, each object is stored in every grid cell its rect touches
+class HitTester {
+public:
+    using Id = uint32_t;
+    static constexpr Id none = UINT32_MAX;
+
+    explicit HitTester(int cell_size = 64);
+
+    // rects passed to insert and move are in simulation coordinates and get mapped onto parent with
+    // Window::calculate_logical_rect, call this again when the window is resized, until its called rects are in screen coordinates
+    void set_logical_space(SDL_Rect parent, float sim_width, float sim_height);
+
+    Id insert(SDL_Rect rect, int32_t z = 0);
+    void move(Id id, SDL_Rect rect);
+    void set_z(Id id, int32_t z);
+    void remove(Id id);
+    void clear();
+
+    // x and y are screen coordinates such as inputs::getMouse(), returns none when nothing is there
+    // the highest z wins, objects with the same z go by which was inserted last
+    Id pick(int32_t x, int32_t y);
+    // appends every object overlapping the screen space area to out, in no particular order
+    void query(SDL_Rect area, std::vector<Id>& out);
+
+    SDL_Rect get_screen_rect(Id id) const;
+    size_t size() const;
+
+private:
+    struct Object {
+        SDL_Rect logical;
+        SDL_Rect screen;
+        int32_t z;
+        // ids get reused, so which object was inserted last is decided by this instead
+        uint64_t sequence;
+        // the last query that saw this object, so objects spanning several cells are only reported once
+        uint32_t stamp;
+        bool alive;
+    };
+
+    struct CellRange {
+        int32_t x0, y0, x1, y1;
+        bool operator==(const CellRange&) const = default;
+    };
+
+    SDL_Rect to_screen(SDL_Rect logical) const;
+    CellRange cells_of(SDL_Rect rect) const;
+    static uint64_t cell_key(int32_t cx, int32_t cy);
+    void link(Id id, CellRange range);
+    void unlink(Id id, CellRange range);
+
+    int cell_size;
+
+    bool has_logical_space = false;
+    SDL_Rect parent = { 0, 0, 0, 0 };
+    float sim_width = 0.f;
+    float sim_height = 0.f;
+
+    std::vector<Object> objects;
+    std::vector<Id> free_ids;
+    // empty cells are left in place so objects moving back and forth dont reallocate them
+    std::unordered_map<uint64_t, std::vector<Id>> cells;
+    uint32_t query_stamp = 0;
+    uint64_t next_sequence = 0;
+    size_t live = 0;
+};
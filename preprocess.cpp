@@ -0,0 +1,411 @@
+#include "preprocess.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define SDLPP_PREPROCESS_SSE2
+#include <emmintrin.h>
+#endif
+
+Uint32 nativeTextureFormat(Window& window, bool needsAlpha) {
+	SDL_RendererInfo info{};
+	if (SDL_GetRendererInfo(window.get_renderer(), &info) == 0) {
+		// renderers list their formats best first
+		for (Uint32 i = 0; i < info.num_texture_formats; ++i) {
+			Uint32 format = info.texture_formats[i];
+
+			if (SDL_ISPIXELFORMAT_INDEXED(format) || SDL_BITSPERPIXEL(format) != 32)
+				continue;
+			if (needsAlpha && !SDL_ISPIXELFORMAT_ALPHA(format))
+				continue;
+
+			return format;
+		}
+	}
+	return SDL_PIXELFORMAT_ARGB8888;
+}
+
+static bool rendererSupports(Window& window, Uint32 format) {
+	SDL_RendererInfo info{};
+	if (SDL_GetRendererInfo(window.get_renderer(), &info) != 0)
+		return false;
+
+	for (Uint32 i = 0; i < info.num_texture_formats; ++i)
+		if (info.texture_formats[i] == format)
+			return true;
+	return false;
+}
+
+// one pass over the alpha channel, stops at the first row with a pixel that isnt fully opaque
+static bool hasTranslucentPixels(SDL_Surface* surface) {
+	const SDL_PixelFormat* fmt = surface->format;
+	if (SDL_HasColorKey(surface))
+		return true;
+
+	if (fmt->palette) {
+		for (int i = 0; i < fmt->palette->ncolors; ++i) {
+			if (fmt->palette->colors[i].a != 255)
+				return true;
+		}
+		return false;
+	}
+
+	if (fmt->Amask == 0)
+		return false;
+	if (fmt->BytesPerPixel != 4)
+		return true;
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	bool translucent = false;
+	for (int y = 0; y < surface->h && !translucent; ++y) {
+		const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(surface->pixels) + y * surface->pitch);
+
+		// no early out inside the row so the loop vectorizes
+		Uint32 alpha = fmt->Amask;
+		for (int x = 0; x < surface->w; ++x)
+			alpha &= row[x];
+		translucent = alpha != fmt->Amask;
+	}
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	return translucent;
+}
+
+SDL_Surface* preprocessSurface(Window& window, SDL_Surface* surface, const TextureLoadOptions& options, bool editable) {
+	TextureLoadOptions supported = options;
+	supported.premultiplyAlpha = options.premultiplyAlpha && supportsPremultipliedBlending(window);
+	return preprocessSurface(surface, nativeTextureFormat(window, true), nativeTextureFormat(window, false), supported, editable);
+}
+
+SDL_Surface* preprocessSurface(SDL_Surface* surface, Uint32 alphaFormat, Uint32 opaqueFormat, const TextureLoadOptions& options,
+	bool editable) {
+	if (surface == nullptr)
+		return nullptr;
+
+	// images often carry an alpha channel they never use, those go to the opaque format so reduced storage applies
+	// surfaces that get drawn into keep it, drawing can still make their pixels transparent
+	const Uint32 format = (editable || hasTranslucentPixels(surface)) ? alphaFormat : opaqueFormat;
+
+	if (surface->format->format != format) {
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+		[[unlikely]] if (converted == nullptr) {
+			SDL_Log("SDL2 Error: %s", SDL_GetError());
+			return surface;
+		}
+		SDL_FreeSurface(surface);
+		surface = converted;
+	}
+
+	if (options.premultiplyAlpha && surface->format->Amask != 0)
+		premultiplyAlpha(surface);
+
+	return surface;
+}
+
+void premultiplyAlpha(SDL_Surface* surface) {
+	const SDL_PixelFormat* fmt = surface->format;
+	if (fmt->BytesPerPixel != 4 || fmt->Amask == 0)
+		return;
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	const Uint32 rgbMask = fmt->Rmask | fmt->Gmask | fmt->Bmask;
+
+	for (int y = 0; y < surface->h; ++y) {
+		Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+
+		for (int x = 0; x < surface->w; ++x) {
+			const Uint32 p = row[x];
+			const Uint32 a = (p & fmt->Amask) >> fmt->Ashift;
+			if (a == 255)
+				continue;
+
+			// scale every colour byte by a / 255, the alpha byte is left as is
+			Uint32 out = p & fmt->Amask;
+			for (Uint32 shift = 0; shift < 32; shift += 8) {
+				if (((0xffu << shift) & rgbMask) == 0)
+					continue;
+				Uint32 c = ((p >> shift) & 0xff) * a + 128;
+				c = (c + (c >> 8)) >> 8;
+				out |= c << shift;
+			}
+			row[x] = out;
+		}
+	}
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+}
+
+SDL_Surface* downscaleHalf(SDL_Surface* surface) {
+	if (surface->format->BytesPerPixel != 4 || surface->w < 2 || surface->h < 2)
+		return nullptr;
+
+	const int w = surface->w / 2;
+	const int h = surface->h / 2;
+
+	SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, surface->format->format);
+	if (out == nullptr)
+		return nullptr;
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	// every byte is averaged on its own, so this works for any channel order
+	for (int y = 0; y < h; ++y) {
+		const Uint8* top = static_cast<const Uint8*>(surface->pixels) + (2 * y) * surface->pitch;
+		const Uint8* bottom = top + surface->pitch;
+		Uint8* dst = static_cast<Uint8*>(out->pixels) + y * out->pitch;
+
+		int x = 0;
+#ifdef SDLPP_PREPROCESS_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(2);
+
+		// 4 source pixels from each row make 2 destination pixels
+		for (; x + 2 <= w; x += 2) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x * 8));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x * 8));
+
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+			__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum, sum));
+		}
+#endif
+		for (; x < w; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const int i = x * 8 + c;
+				dst[x * 4 + c] = Uint8((top[i] + top[i + 4] + bottom[i] + bottom[i + 4] + 2) >> 2);
+			}
+		}
+	}
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	return out;
+}
+
+Uint32 storageFormat(Window& window, TextureStorage storage, bool hasAlpha) {
+	switch (storage) {
+	case TextureStorage::Full:
+		return 0;
+	case TextureStorage::Palettized8:
+		if (!hasAlpha && rendererSupports(window, SDL_PIXELFORMAT_INDEX8))
+			return SDL_PIXELFORMAT_INDEX8;
+		[[fallthrough]];
+	case TextureStorage::RGB565:
+	case TextureStorage::ARGB4444: {
+		// RGB565 would throw the alpha channel away, so images with alpha keep 4 bits of it instead
+		const Uint32 format = (hasAlpha || storage == TextureStorage::ARGB4444) ? SDL_PIXELFORMAT_ARGB4444 : SDL_PIXELFORMAT_RGB565;
+
+		// a format the renderer doesnt list gets expanded back to 32 bits on upload, so there is nothing to gain
+		return rendererSupports(window, format) ? format : 0;
+	}
+	}
+	return 0;
+}
+
+namespace {
+	struct QuantizeChannel {
+		Uint8 inShift;
+		Uint8 bits;
+		Uint8 outShift;
+	};
+
+	constexpr Uint8 bayer4x4[4][4] = {
+		{ 0, 8, 2, 10 },
+		{ 12, 4, 14, 6 },
+		{ 3, 11, 1, 9 },
+		{ 15, 7, 13, 5 },
+	};
+
+	// what to add before truncating to bits, either the bayer threshold scaled to one step or half a step to round
+	inline Uint32 quantizeOffset(Uint8 bits, bool dither, Uint8 threshold) {
+		const Uint32 step = 1u << (8 - bits);
+		return dither ? (threshold * step) >> 4 : step >> 1;
+	}
+
+	inline Uint32 quantizePixel(Uint32 p, const QuantizeChannel* channels, int count, bool dither, Uint8 threshold) {
+		Uint32 out = 0;
+		for (int c = 0; c < count; ++c) {
+			const QuantizeChannel& ch = channels[c];
+			Uint32 v = ((p >> ch.inShift) & 0xff) + quantizeOffset(ch.bits, dither, threshold);
+			if (v > 255)
+				v = 255;
+			out |= (v >> (8 - ch.bits)) << ch.outShift;
+		}
+		return out;
+	}
+}
+
+SDL_Surface* quantizeSurface(SDL_Surface* surface, Uint32 format, bool dither) {
+	const SDL_PixelFormat* fmt = surface->format;
+	if (fmt->BytesPerPixel != 4)
+		return nullptr;
+
+	QuantizeChannel channels[4];
+	int count = 0;
+	const bool hasAlpha = fmt->Amask != 0;
+
+	switch (format) {
+	case SDL_PIXELFORMAT_RGB565:
+		channels[count++] = { fmt->Rshift, 5, 11 };
+		channels[count++] = { fmt->Gshift, 6, 5 };
+		channels[count++] = { fmt->Bshift, 5, 0 };
+		break;
+	case SDL_PIXELFORMAT_ARGB4444:
+		channels[count++] = { fmt->Rshift, 4, 8 };
+		channels[count++] = { fmt->Gshift, 4, 4 };
+		channels[count++] = { fmt->Bshift, 4, 0 };
+		// surfaces without alpha are opaque, the alpha bits get filled in below
+		if (hasAlpha)
+			channels[count++] = { fmt->Ashift, 4, 12 };
+		break;
+	case SDL_PIXELFORMAT_INDEX8:
+		channels[count++] = { fmt->Rshift, 3, 5 };
+		channels[count++] = { fmt->Gshift, 3, 2 };
+		channels[count++] = { fmt->Bshift, 2, 0 };
+		break;
+	default:
+		return nullptr;
+	}
+
+	const bool wide = format != SDL_PIXELFORMAT_INDEX8;
+	const Uint32 opaque = (format == SDL_PIXELFORMAT_ARGB4444 && !hasAlpha) ? 0xf000 : 0;
+
+	SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h, wide ? 16 : 8, format);
+	if (out == nullptr)
+		return nullptr;
+
+	if (!wide) {
+		// the index is the 3-3-2 colour itself, so the palette just spells those out
+		SDL_Color palette[256];
+		for (int i = 0; i < 256; ++i) {
+			palette[i] = {
+				Uint8(((i >> 5) & 7) * 255 / 7),
+				Uint8(((i >> 2) & 7) * 255 / 7),
+				Uint8((i & 3) * 255 / 3),
+				255 };
+		}
+		SDL_SetPaletteColors(out->format->palette, palette, 0, 256);
+	}
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	for (int y = 0; y < surface->h; ++y) {
+		const Uint32* src = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(surface->pixels) + y * surface->pitch);
+		Uint8* dst = static_cast<Uint8*>(out->pixels) + y * out->pitch;
+		const Uint8* thresholds = bayer4x4[y & 3];
+
+		int x = 0;
+		if (wide) {
+			Uint16* dst16 = reinterpret_cast<Uint16*>(dst);
+#ifdef SDLPP_PREPROCESS_SSE2
+			// x only ever moves in steps of 4, so the 4 lanes line up with one row of the bayer matrix
+			__m128i offsets[4];
+			for (int c = 0; c < count; ++c) {
+				const Uint8 bits = channels[c].bits;
+				offsets[c] = _mm_setr_epi32(
+					int(quantizeOffset(bits, dither, thresholds[0])), int(quantizeOffset(bits, dither, thresholds[1])),
+					int(quantizeOffset(bits, dither, thresholds[2])), int(quantizeOffset(bits, dither, thresholds[3])));
+			}
+
+			const __m128i byteMask = _mm_set1_epi32(0xff);
+			const __m128i max = _mm_set1_epi32(255);
+			const __m128i bias32 = _mm_set1_epi32(0x8000);
+			const __m128i bias16 = _mm_set1_epi16(short(0x8000));
+			const __m128i fill = _mm_set1_epi32(int(opaque));
+
+			for (; x + 4 <= surface->w; x += 4) {
+				const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				__m128i acc = fill;
+
+				for (int c = 0; c < count; ++c) {
+					__m128i v = _mm_and_si128(_mm_srl_epi32(p, _mm_cvtsi32_si128(channels[c].inShift)), byteMask);
+					// every lane is below 512 so a 16 bit min is enough to clamp it
+					v = _mm_min_epi16(_mm_add_epi32(v, offsets[c]), max);
+					v = _mm_srl_epi32(v, _mm_cvtsi32_si128(8 - channels[c].bits));
+					acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(channels[c].outShift)));
+				}
+
+				// sse2 only has a signed 32 to 16 bit pack, so shift the range down and back around it
+				__m128i packed = _mm_packs_epi32(_mm_sub_epi32(acc, bias32), _mm_sub_epi32(acc, bias32));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dst16 + x), _mm_xor_si128(packed, bias16));
+			}
+#endif
+			for (; x < surface->w; ++x)
+				dst16[x] = Uint16(opaque | quantizePixel(src[x], channels, count, dither, thresholds[x & 3]));
+		} else {
+			for (; x < surface->w; ++x)
+				dst[x] = Uint8(quantizePixel(src[x], channels, count, dither, thresholds[x & 3]));
+		}
+	}
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	return out;
+}
+
+size_t textureBytes(SDL_Texture* texture) {
+	Uint32 format = 0;
+	int w = 0, h = 0;
+	if (texture == nullptr || SDL_QueryTexture(texture, &format, nullptr, &w, &h) != 0)
+		return 0;
+
+	return size_t(w) * size_t(h) * SDL_BYTESPERPIXEL(format);
+}
+
+SDL_BlendMode premultipliedBlendMode() {
+	return SDL_ComposeCustomBlendMode(
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+}
+
+bool supportsPremultipliedBlending(Window& window) {
+	// there is no query for it, so try it on a throwaway texture once per renderer
+	static SDL_Renderer* checked = nullptr;
+	static bool supported = false;
+
+	SDL_Renderer* renderer = window.get_renderer();
+	if (renderer == checked)
+		return supported;
+
+	supported = false;
+	if (SDL_Texture* probe = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1)) {
+		supported = SDL_SetTextureBlendMode(probe, premultipliedBlendMode()) == 0;
+		SDL_DestroyTexture(probe);
+	}
+	checked = renderer;
+	return supported;
+}
+
+SDL_Texture* createPreprocessedTexture(Window& window, SDL_Surface* surface, const TextureLoadOptions& options) {
+	SDL_Texture* texture = nullptr;
+
+	const Uint32 format = storageFormat(window, options.storage, surface->format->Amask != 0);
+	SDL_Surface* quantized = format ? quantizeSurface(surface, format, options.dither) : nullptr;
+	if (quantized) {
+		texture = SDL_CreateTextureFromSurface(window.get_renderer(), quantized);
+		SDL_FreeSurface(quantized);
+	} else {
+		texture = SDL_CreateTextureFromSurface(window.get_renderer(), surface);
+	}
+
+	// the pixels were only premultiplied if the renderer could blend them that way
+	if (texture && options.premultiplyAlpha && surface->format->Amask != 0 && supportsPremultipliedBlending(window)) {
+		[[unlikely]] if (SDL_SetTextureBlendMode(texture, premultipliedBlendMode()) != 0)
+			SDL_Log("SDL2 Error: %s", SDL_GetError());
+	}
+
+	return texture;
+}
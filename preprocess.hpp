@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+#include "../SDLpp/Window.hpp"
+
+// how many bits per pixel a texture is kept at on the gpu
+enum class TextureStorage : uint8_t {
+	Full,
+	RGB565,
+	ARGB4444,
+	// 8 bit indices into a fixed 3-3-2 palette, only for opaque images
+	Palettized8,
+};
+
+// what to do with a surface between decoding it and uploading it
+struct TextureLoadOptions {
+	// multiply the colour channels by alpha once at load, the texture then draws with premultipliedBlendMode()
+	bool premultiplyAlpha = false;
+	// how many downscaled variants to build, 1 builds a half size one and 2 also a quarter size one
+	uint8_t downscaleLevels = 0;
+	// reduced precision formats only apply when the renderer can take them as is, otherwise it stays Full
+	TextureStorage storage = TextureStorage::Full;
+	// ordered dithering while quantizing, hides banding in gradients
+	bool dither = false;
+	// keep the preprocessed surface around so a lost device can be recovered from without decoding again
+	bool retainSurface = false;
+};
+
+// the 32 bit format the renderer takes without converting, ARGB8888 if it doesnt list one
+Uint32 nativeTextureFormat(Window& window, bool needsAlpha);
+
+// converts the surface to the renderers native format and applies the options, images without a translucent pixel
+// lose their alpha channel so storageFormat treats them as opaque, unless editable is set because they get drawn into
+// takes ownership of surface, the returned surface may be the same one
+SDL_Surface* preprocessSurface(Window& window, SDL_Surface* surface, const TextureLoadOptions& options, bool editable = false);
+// same as above with the native formats already looked up, doesnt touch the renderer so it is safe off the main thread
+SDL_Surface* preprocessSurface(SDL_Surface* surface, Uint32 alphaFormat, Uint32 opaqueFormat, const TextureLoadOptions& options,
+	bool editable = false);
+
+// the pixel format storage resolves to on this renderer, 0 when the texture should stay at full precision
+// Palettized8 falls back to RGB565 for renderers without INDEX8 textures, and to ARGB4444 for images with alpha
+Uint32 storageFormat(Window& window, TextureStorage storage, bool hasAlpha);
+
+// quantizes a 32 bit surface into a new RGB565, ARGB4444 or INDEX8 surface
+SDL_Surface* quantizeSurface(SDL_Surface* surface, Uint32 format, bool dither);
+
+// how much memory the texture takes at its actual format
+size_t textureBytes(SDL_Texture* texture);
+
+// surface has to be 32 bits per pixel with an alpha channel
+void premultiplyAlpha(SDL_Surface* surface);
+
+// 2x2 box filter into a new surface of the same format, returns nullptr if the surface is too small
+// surface has to be 32 bits per pixel
+SDL_Surface* downscaleHalf(SDL_Surface* surface);
+
+// dst = src + dst * (1 - src alpha), which is what premultiplied colours need
+SDL_BlendMode premultipliedBlendMode();
+// custom blend modes are up to the renderer (the software one has none), without it premultiplying is skipped
+bool supportsPremultipliedBlending(Window& window);
+
+// uploads the surface in the storage format and sets the blend mode the options call for, the surface is not freed
+SDL_Texture* createPreprocessedTexture(Window& window, SDL_Surface* surface, const TextureLoadOptions& options);
@@ -0,0 +1,336 @@
+#include "raster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+	// locks the surface for the lifetime of the draw call and does the clipped, blended pixel writes
+	class Target {
+	public:
+		Target(SDL_Surface* surface, SDL_Color color) : surface(surface), color(color) {
+			valid = surface != nullptr && surface->format->BytesPerPixel == 4;
+			if (!valid)
+				return;
+
+			if (SDL_MUSTLOCK(surface))
+				SDL_LockSurface(surface);
+
+			const SDL_Rect whole = { 0, 0, surface->w, surface->h };
+			if (!SDL_IntersectRect(&surface->clip_rect, &whole, &clip))
+				clip = { 0, 0, 0, 0 };
+
+			const SDL_PixelFormat* format = surface->format;
+			rshift = format->Rshift;
+			gshift = format->Gshift;
+			bshift = format->Bshift;
+			ashift = format->Ashift;
+			amask = format->Amask;
+			opaque = SDL_MapRGBA(format, color.r, color.g, color.b, 255);
+		}
+		~Target() {
+			if (valid && SDL_MUSTLOCK(surface))
+				SDL_UnlockSurface(surface);
+		}
+		Target(const Target&) = delete;
+		Target& operator=(const Target&) = delete;
+
+		bool ok() const { return valid && clip.w > 0 && clip.h > 0; }
+		const SDL_Rect& bounds() const { return clip; }
+
+		// coverage is 0 to 255, multiplied with the colours alpha
+		inline void plot(int32_t x, int32_t y, uint32_t coverage) {
+			if (x < clip.x || y < clip.y || x >= clip.x + clip.w || y >= clip.y + clip.h)
+				return;
+			Uint32* pixel = row(y) + x;
+			*pixel = blend(*pixel, (color.a * coverage + 127) / 255);
+		}
+
+		// fills [x0, x1] on row y, the ends are wide enough for shapes reaching far outside the surface
+		inline void span(int64_t y, int64_t x0, int64_t x1) {
+			if (y < clip.y || y >= clip.y + clip.h)
+				return;
+			x0 = std::max<int64_t>(x0, clip.x);
+			x1 = std::min<int64_t>(x1, clip.x + clip.w - 1);
+			if (x0 > x1)
+				return;
+
+			Uint32* pixels = row(int32_t(y));
+			if (color.a == 255) {
+				std::fill(pixels + x0, pixels + x1 + 1, opaque);
+				return;
+			}
+			for (int64_t x = x0; x <= x1; ++x)
+				pixels[x] = blend(pixels[x], color.a);
+		}
+
+	private:
+		inline Uint32* row(int32_t y) const {
+			return reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+		}
+
+		// source over, channels are 8 bits in every 32 bit format so shifting is enough to find them
+		inline Uint32 blend(Uint32 dst, uint32_t alpha) const {
+			if (alpha >= 255)
+				return opaque;
+			if (alpha == 0)
+				return dst;
+
+			const uint32_t inv = 255 - alpha;
+			auto mix = [&](uint32_t src, uint8_t shift) {
+				const uint32_t d = (dst >> shift) & 0xff;
+				return ((src * alpha + d * inv + 127) / 255) << shift;
+			};
+
+			Uint32 out = mix(color.r, rshift) | mix(color.g, gshift) | mix(color.b, bshift);
+			if (amask) {
+				const uint32_t d = (dst & amask) >> ashift;
+				out |= ((alpha + (d * inv + 127) / 255) << ashift) & amask;
+			}
+			return out;
+		}
+
+		SDL_Surface* surface;
+		SDL_Color color;
+		SDL_Rect clip = { 0, 0, 0, 0 };
+		bool valid = false;
+		uint8_t rshift = 0, gshift = 0, bshift = 0, ashift = 0;
+		Uint32 amask = 0;
+		Uint32 opaque = 0;
+	};
+
+	// the outermost x the outline of an rx by ry ellipse reaches on row y of the bottom right quadrant, y in [0, ry]
+	// the larger of where the row crosses the ellipse and the last column that crosses it within this row,
+	// so both the flat top and the steep sides come out connected, for circles these are the midpoint algorithms pixels
+	// works per row so drawing only has to look at the rows inside the clip rect, however big the ellipse is
+	inline int64_t ellipseExtent(int32_t rx, int32_t ry, int64_t y) {
+		auto crossing = [&](double row) {
+			return double(rx) / double(ry) * std::sqrt(std::max(0.0, (double(ry) - row) * (double(ry) + row)));
+		};
+		const int64_t rowSample = int64_t(std::floor(crossing(double(y)) + 0.5));
+		const int64_t columns = int64_t(std::floor(crossing(double(y) - 0.5)));
+		return std::min<int64_t>(std::max(rowSample, columns), rx);
+	}
+
+	// the rows of [cy - ry, cy + ry] inside the clip rect, as offsets from cy
+	inline bool visibleRows(const SDL_Rect& clip, int32_t cy, int32_t ry, int64_t& first, int64_t& last) {
+		first = std::max<int64_t>(int64_t(clip.y) - cy, -int64_t(ry));
+		last = std::min<int64_t>(int64_t(clip.y) + clip.h - 1 - cy, ry);
+		return first <= last;
+	}
+
+	struct Edge {
+		int32_t lastRow;
+		// 16.16 fixed point x at the current row and how much it moves per row
+		int64_t x;
+		int64_t step;
+	};
+
+	constexpr int64_t fixedOne = int64_t(1) << 16;
+}
+
+void raster::line(SDL_Surface* surface, float x0, float y0, float x1, float y1, SDL_Color color) {
+	Target target(surface, color);
+	if (!target.ok())
+		return;
+
+	// pixel centers at .5 turn into integer coordinates, which is what the algorithm works in
+	x0 -= 0.5f;
+	y0 -= 0.5f;
+	x1 -= 0.5f;
+	y1 -= 0.5f;
+
+	const bool steep = std::fabs(y1 - y0) > std::fabs(x1 - x0);
+	if (steep) {
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+	if (x0 > x1) {
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+	}
+
+	auto plot = [&](int32_t major, int32_t minor, float coverage) {
+		const uint32_t c = uint32_t(std::clamp(coverage, 0.f, 1.f) * 255.f + 0.5f);
+		if (steep)
+			target.plot(minor, major, c);
+		else
+			target.plot(major, minor, c);
+	};
+	auto fpart = [](float v) { return v - std::floor(v); };
+
+	const float dx = x1 - x0;
+	const float gradient = dx == 0.f ? 1.f : (y1 - y0) / dx;
+
+	// the end points only cover the part of their pixel the line actually reaches
+	float xend = std::round(x0);
+	float yend = y0 + gradient * (xend - x0);
+	float xgap = 1.f - fpart(x0 + 0.5f);
+	const int32_t xstart = int32_t(xend);
+	plot(xstart, int32_t(std::floor(yend)), (1.f - fpart(yend)) * xgap);
+	plot(xstart, int32_t(std::floor(yend)) + 1, fpart(yend) * xgap);
+	float intery = yend + gradient;
+
+	xend = std::round(x1);
+	yend = y1 + gradient * (xend - x1);
+	xgap = fpart(x1 + 0.5f);
+	const int32_t xstop = int32_t(xend);
+	if (xstop != xstart) {
+		plot(xstop, int32_t(std::floor(yend)), (1.f - fpart(yend)) * xgap);
+		plot(xstop, int32_t(std::floor(yend)) + 1, fpart(yend) * xgap);
+	}
+
+	// only walk the part of the major axis that can land inside the clip rect
+	const SDL_Rect& clip = target.bounds();
+	const int32_t majorMin = steep ? clip.y : clip.x;
+	const int32_t majorMax = steep ? clip.y + clip.h - 1 : clip.x + clip.w - 1;
+
+	int32_t first = xstart + 1;
+	const int32_t last = std::min(xstop - 1, majorMax);
+	if (first < majorMin) {
+		intery += gradient * float(majorMin - first);
+		first = majorMin;
+	}
+
+	for (int32_t x = first; x <= last; ++x) {
+		const int32_t y = int32_t(std::floor(intery));
+		plot(x, y, 1.f - fpart(intery));
+		plot(x, y + 1, fpart(intery));
+		intery += gradient;
+	}
+}
+
+void raster::ellipse(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t rx, int32_t ry, SDL_Color color) {
+	if (rx < 0 || ry < 0)
+		return;
+
+	Target target(surface, color);
+	if (!target.ok())
+		return;
+
+	if (ry == 0) {
+		target.span(cy, int64_t(cx) - rx, int64_t(cx) + rx);
+		return;
+	}
+
+	int64_t first, last;
+	if (!visibleRows(target.bounds(), cy, ry, first, last))
+		return;
+
+	// every row gets the run between where the row below it ended and its own extent, mirrored to the left
+	// the column on the axis is only drawn once, plotting it twice would blend it twice
+	for (int64_t dy = first; dy <= last; ++dy) {
+		const int64_t y = dy < 0 ? -dy : dy;
+		const int64_t outer = ellipseExtent(rx, ry, y);
+		const int64_t inner = y == ry ? 0 : std::min(ellipseExtent(rx, ry, y + 1) + 1, outer);
+
+		target.span(cy + dy, cx + inner, cx + outer);
+		if (outer > 0)
+			target.span(cy + dy, cx - outer, cx - std::max<int64_t>(inner, 1));
+	}
+}
+
+void raster::ellipseFilled(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t rx, int32_t ry, SDL_Color color) {
+	if (rx < 0 || ry < 0)
+		return;
+
+	Target target(surface, color);
+	if (!target.ok())
+		return;
+
+	if (ry == 0) {
+		target.span(cy, int64_t(cx) - rx, int64_t(cx) + rx);
+		return;
+	}
+
+	// the same extents ellipse() draws its outline to, so the fill covers exactly what the outline does
+	int64_t first, last;
+	if (!visibleRows(target.bounds(), cy, ry, first, last))
+		return;
+
+	for (int64_t dy = first; dy <= last; ++dy) {
+		const int64_t outer = ellipseExtent(rx, ry, dy < 0 ? -dy : dy);
+		target.span(cy + dy, cx - outer, cx + outer);
+	}
+}
+
+void raster::circle(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t radius, SDL_Color color) {
+	ellipse(surface, cx, cy, radius, radius, color);
+}
+
+void raster::circleFilled(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t radius, SDL_Color color) {
+	ellipseFilled(surface, cx, cy, radius, radius, color);
+}
+
+void raster::polygonFilled(SDL_Surface* surface, const SDL_FPoint* points, size_t count, SDL_Color color) {
+	if (points == nullptr || count < 3)
+		return;
+
+	Target target(surface, color);
+	if (!target.ok())
+		return;
+
+	const SDL_Rect& clip = target.bounds();
+	const int32_t clipBottom = clip.y + clip.h - 1;
+
+	// row y is sampled at y + .5, an edge covers the rows whose sample falls in [top, bottom)
+	struct Pending {
+		int32_t firstRow;
+		Edge edge;
+	};
+	std::vector<Pending> pending;
+	pending.reserve(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		SDL_FPoint a = points[i];
+		SDL_FPoint b = points[(i + 1) % count];
+		if (a.y == b.y)
+			continue;
+		if (a.y > b.y)
+			std::swap(a, b);
+
+		int32_t firstRow = int32_t(std::ceil(a.y - 0.5f));
+		const int32_t lastRow = std::min(int32_t(std::ceil(b.y - 0.5f)) - 1, clipBottom);
+		firstRow = std::max(firstRow, clip.y);
+		if (firstRow > lastRow)
+			continue;
+
+		const double slope = double(b.x - a.x) / double(b.y - a.y);
+		const double x = a.x + slope * (firstRow + 0.5 - a.y);
+		pending.push_back({ firstRow, { lastRow, int64_t(std::llround(x * fixedOne)), int64_t(std::llround(slope * fixedOne)) } });
+	}
+	if (pending.empty())
+		return;
+
+	std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) { return a.firstRow < b.firstRow; });
+
+	std::vector<Edge> active;
+	std::vector<int64_t> crossings;
+	size_t next = 0;
+
+	for (int32_t y = pending.front().firstRow; y <= clipBottom; ++y) {
+		while (next < pending.size() && pending[next].firstRow == y)
+			active.push_back(pending[next++].edge);
+
+		active.erase(std::remove_if(active.begin(), active.end(), [y](const Edge& e) { return e.lastRow < y; }), active.end());
+		if (active.empty()) {
+			if (next == pending.size())
+				break;
+			continue;
+		}
+
+		crossings.clear();
+		for (Edge& edge : active) {
+			crossings.push_back(edge.x);
+			edge.x += edge.step;
+		}
+		std::sort(crossings.begin(), crossings.end());
+
+		// a pixel is filled when its center x + .5 lies in [left, right)
+		for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+			const int32_t left = int32_t((crossings[i] - fixedOne / 2 + fixedOne - 1) >> 16);
+			const int32_t right = int32_t((crossings[i + 1] - fixedOne / 2 + fixedOne - 1) >> 16) - 1;
+			target.span(y, left, right);
+		}
+	}
+}
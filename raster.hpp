@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+// draws straight into 32 bit surfaces on the cpu, so procedural textures never have to go through the renderer
+// and get read back, nothing here touches the renderer or global state, so different surfaces can be drawn on
+// from different threads at the same time
+// colours are blended over what is already there, everything is clipped to the surface clip rect
+// surfaces that arent 4 bytes per pixel are left alone
+namespace raster {
+	// anti-aliased (Xiaolin Wu) line between two points, pixel centers are at .5
+	void line(SDL_Surface* surface, float x0, float y0, float x1, float y1, SDL_Color color);
+
+	void circle(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t radius, SDL_Color color);
+	void circleFilled(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t radius, SDL_Color color);
+	void ellipse(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t rx, int32_t ry, SDL_Color color);
+	void ellipseFilled(SDL_Surface* surface, int32_t cx, int32_t cy, int32_t rx, int32_t ry, SDL_Color color);
+
+	// even-odd scanline fill, a pixel is inside when its center is, so polygons sharing an edge dont overlap
+	void polygonFilled(SDL_Surface* surface, const SDL_FPoint* points, size_t count, SDL_Color color);
+}
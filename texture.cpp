@@ -1,96 +1,361 @@
 //not my code
 #include "texture.hpp"
+#include <algorithm>
+#include <atomic>
 #include <string_view>
 
+// the texture belongs to one surface object, so setting its modulation right before the copy makes it per draw
+static void applyModulation(SDL_Texture* texture, SDL_Color colorMod, SDL_BlendMode blendMode) {
+	SDL_SetTextureColorMod(texture, colorMod.r, colorMod.g, colorMod.b);
+	SDL_SetTextureAlphaMod(texture, colorMod.a);
+	if (blendMode != SDL_BLENDMODE_INVALID)
+		SDL_SetTextureBlendMode(texture, blendMode);
+}
 
-void SurfaceTexture::load(Window& window, std::string path, int32_t x, int32_t y) {
+void SurfaceTexture::load(Window& window, std::string_view path, int32_t x, int32_t y) {
 	(*this) = TextureDictionary::getSurfaceTexture(window, path);
 }
 
 void SurfaceTexture::createSurface(Window& window, int32_t x, int32_t y) {
-	this->surface = SDL_CreateRGBSurface(0, x, y, 32, 0, 0, 0, 0);
+	this->surface = SDL_CreateRGBSurfaceWithFormat(0, x, y, 32, nativeTextureFormat(window, false));
 	this->destRect = { 0,0,x,y };
 	// the texture likely is changing every frame so only create it when rendering
 	this->texture = nullptr;
+	this->dirty = true;
 }
 
 void SurfaceTexture::drawRectFilled(Window& window, SDL_Rect dest) {
 	// get the draw color from the window
 	Uint8 r, g, b, a;
-	window.getDrawColor(r, g, b, a);
+	window.get_draw_color(r, g, b, a);
 	
 	SDL_FillRect(this->surface, &dest, SDL_MapRGBA(this->surface->format, r, g, b, a));
+	this->dirty = true;
 }
 
 void SurfaceTexture::blitSurface(Window& window, SDL_Surface* src, SDL_Rect dest) {
 	SDL_Rect src_rect = { 0,0,src->w,src->h };
 	SDL_BlitScaled(src, &src_rect, this->surface, &dest);
+	this->dirty = true;
 }
 
-void SurfaceTexture::render(Window& window) {
+static SDL_Color windowDrawColor(Window& window) {
+	SDL_Color color;
+	window.get_draw_color(color.r, color.g, color.b, color.a);
+	return color;
+}
+
+void SurfaceTexture::drawLine(Window& window, float x0, float y0, float x1, float y1) {
+	raster::line(this->surface, x0, y0, x1, y1, windowDrawColor(window));
+	this->dirty = true;
+}
+
+void SurfaceTexture::drawCircle(Window& window, int32_t x, int32_t y, int32_t radius) {
+	raster::circle(this->surface, x, y, radius, windowDrawColor(window));
+	this->dirty = true;
+}
+
+void SurfaceTexture::drawCircleFilled(Window& window, int32_t x, int32_t y, int32_t radius) {
+	raster::circleFilled(this->surface, x, y, radius, windowDrawColor(window));
+	this->dirty = true;
+}
+
+void SurfaceTexture::drawEllipse(Window& window, int32_t x, int32_t y, int32_t rx, int32_t ry) {
+	raster::ellipse(this->surface, x, y, rx, ry, windowDrawColor(window));
+	this->dirty = true;
+}
+
+void SurfaceTexture::drawEllipseFilled(Window& window, int32_t x, int32_t y, int32_t rx, int32_t ry) {
+	raster::ellipseFilled(this->surface, x, y, rx, ry, windowDrawColor(window));
+	this->dirty = true;
+}
 
-#ifdef WIN32
-	[[unlikely]]
-#endif
-	// this should never fail on PC
-	if (window.render({ 0,0,0,0 }, this->destRect, this->texture))
+void SurfaceTexture::drawPolygonFilled(Window& window, const SDL_FPoint* points, size_t count) {
+	raster::polygonFilled(this->surface, points, count, windowDrawColor(window));
+	this->dirty = true;
+}
+
+void SurfaceTexture::buildMask(uint8_t alphaThreshold) {
+	if (surface == nullptr) {
+		mask = CollisionMask();
 		return;
+	}
+	mask = CollisionMask::fromSurface(surface, { 0, 0, surface->w, surface->h }, alphaThreshold);
+}
 
-	if(this->surface)
-	{
+void SurfaceTexture::render(Window& window) {
+	// the only upload happens here, for textures that were never made, whose surface was drawn into,
+	// or that a lost device took with it
+	[[unlikely]] if (this->texture == nullptr || this->dirty || this->epoch != window.get_reset_epoch())
 		this->createTexture(window);
-		if (window.render({ 0,0,0,0 }, this->destRect, this->texture))
-			return;
-	}
 
-	// if all else fails, reload the texture from the path
-	(*this) = TextureDictionary::reloadST(window, this->path);
+	applyModulation(this->texture, this->colorMod, this->blendMode);
 	window.render({ 0,0,0,0 }, this->destRect, this->texture);
 }
 
 
-void Sprite::load(Window& window, std::string path, [[maybe_unused]] int32_t x, [[maybe_unused]] int32_t y) {
+void Sprite::load(Window& window, std::string_view path, [[maybe_unused]] int32_t x, [[maybe_unused]] int32_t y) {
 	(*this) = TextureDictionary::getSprite(window, path);
 }
 
+// the texture of a dictionary owned renderable goes through its handle, so one released with
+// TextureDictionary::release comes back as nullptr instead of a dangling pointer
+static Texture* liveTexture(const Renderable& renderable) {
+	if (renderable.handle.index == UINT32_MAX)
+		return renderable.texture;
+	return TextureDictionary::get(renderable.handle);
+}
+
 void Sprite::render(Window& window) {
-	// this reloading is only neccesary when on android as when you rotate the screen the texture is for some reason not tied to the renderer anymore
-#ifdef WIN32
-	[[unlikely]]
-#endif
-	if (window.render(this->srcRect, this->destRect, this->texture->texture))
+	// a lost device (android does this when the screen rotates) is handled by TextureDictionary::reuploadAll
+	// before the frame starts, so there is nothing to recover from here
+	Texture* texture = liveTexture(*this);
+	if (texture == nullptr) [[unlikely]]
 		return;
 
-	(*this) = TextureDictionary::reloadSP(window, this->texture->path);
-	window.render(this->srcRect, this->destRect, this->texture->texture);
+	SDL_Rect src = this->srcRect;
+	SDL_Texture* tex = texture->select(src, this->destRect);
+	window.render(src, this->destRect, tex);
+}
+
+void Sprite::queue(Window& window, uint8_t layer, uint32_t depth) {
+	Texture* texture = liveTexture(*this);
+	if (texture == nullptr) [[unlikely]]
+		return;
 
+	SDL_Rect src = this->srcRect;
+	SDL_Texture* tex = texture->select(src, this->destRect);
+	window.queue(src, this->destRect, tex, layer, depth);
 }
 
 
 
-void SpriteSheet::load(Window& window, std::string path, int32_t x, int32_t y) {
+void SpriteSheet::load(Window& window, std::string_view path, int32_t x, int32_t y) {
 
 	(*this) = TextureDictionary::getSpriteSheet(window, path, x, y);
 }
 
 void SpriteSheet::render(Window& window) {
-	// this reloading is only neccesary when on android as when you rotate the screen the texture is for some reason not tied to the renderer anymore
-#ifdef WIN32
-	[[unlikely]]
-#endif
-	if (window.render(this->srcRect, this->destRect, this->texture->texture))
+	Texture* texture = liveTexture(*this);
+	if (texture == nullptr) [[unlikely]]
+		return;
+
+	SDL_Rect src = this->srcRect;
+	SDL_Texture* tex = texture->select(src, this->destRect);
+	window.render(src, this->destRect, tex);
+}
+
+void SpriteSheet::queue(Window& window, uint8_t layer, uint32_t depth) {
+	Texture* texture = liveTexture(*this);
+	if (texture == nullptr) [[unlikely]]
 		return;
 
-	(*this) = TextureDictionary::reloadSS(window, this->texture->path, tile_x, tile_y);
-	window.render(this->srcRect, this->destRect, this->texture->texture);
+	SDL_Rect src = this->srcRect;
+	SDL_Texture* tex = texture->select(src, this->destRect);
+	window.queue(src, this->destRect, tex, layer, depth);
 }
 
 void SpriteSheet::updateSection(uint8_t x, uint8_t y) {
 	this->srcRect = { x * tile_x, y * tile_y, tile_x, tile_y };
 }
 
-Texture* TextureDictionary::loadTexture(Window& window, std::string_view p_filePath) {
-	return new Texture(window, p_filePath);
+void Texture::upload(Window& window, SDL_Surface* surface) {
+	destroy();
+	if (surface == nullptr)
+		return;
+
+	this->texture = createPreprocessedTexture(window, surface, options);
+	this->bytes = textureBytes(this->texture);
+	this->fullBytes = size_t(surface->w) * size_t(surface->h) * 4;
+
+	// each variant is filtered from the previous one, not from the full size surface
+	SDL_Surface* level = surface;
+	for (int i = 0; i < options.downscaleLevels && i < 2; ++i) {
+		SDL_Surface* next = downscaleHalf(level);
+		if (next == nullptr)
+			break;
+
+		this->variants[i] = createPreprocessedTexture(window, next, options);
+		this->bytes += textureBytes(this->variants[i]);
+		this->fullBytes += size_t(next->w) * size_t(next->h) * 4;
+
+		if (level != surface)
+			SDL_FreeSurface(level);
+		level = next;
+	}
+
+	if (level != surface)
+		SDL_FreeSurface(level);
+
+	if (surface == retained)
+		return;
+
+	if (options.retainSurface) {
+		if (retained)
+			SDL_FreeSurface(retained);
+		retained = surface;
+	} else {
+		SDL_FreeSurface(surface);
+	}
+}
+
+std::unique_ptr<Texture> TextureDictionary::loadTexture(Window& window, AssetId id) {
+	TextureLoadOptions options = loadOptions;
+	if (auto it = storageOverrides.find(id); it != storageOverrides.end())
+		options.storage = it->second;
+
+	return std::make_unique<Texture>(window, assetPaths[id], options);
+}
+
+void TextureDictionary::setStorage(std::string_view path, TextureStorage storage) {
+	storageOverrides[intern(path)] = storage;
+}
+
+void TextureDictionary::attach(Window& window) {
+	// the window keeps track of which listeners are ours, so a window that replaced a destroyed one at the
+	// same address still gets one, and going back and forth between windows doesnt add more
+	if (window.has_renderer_reset_listener(&slots))
+		return;
+
+	window.on_renderer_reset([](Window& window, bool device_lost) {
+		// losing only the render targets leaves static textures alone
+		if (device_lost)
+			reuploadAll(window);
+	}, &slots);
+}
+
+void TextureDictionary::reuploadAll(Window& window) {
+	std::vector<Texture*> decode;
+
+	for (Slot& slot : slots) {
+		if (!slot.texture)
+			continue;
+
+		if (slot.texture->retained)
+			slot.texture->upload(window, slot.texture->retained);
+		else
+			decode.push_back(slot.texture.get());
+	}
+
+	if (decode.empty())
+		return;
+
+	// the renderer is only touched on this thread, the workers just decode and convert
+	const Uint32 alphaFormat = nativeTextureFormat(window, true);
+	const Uint32 opaqueFormat = nativeTextureFormat(window, false);
+	const bool premultiply = supportsPremultipliedBlending(window);
+
+	std::vector<SDL_Surface*> surfaces(decode.size(), nullptr);
+	std::atomic<size_t> next = 0;
+
+	auto worker = [&] {
+		for (size_t i = next++; i < decode.size(); i = next++) {
+			const Texture& texture = *decode[i];
+			TextureLoadOptions options = texture.options;
+			options.premultiplyAlpha = options.premultiplyAlpha && premultiply;
+			surfaces[i] = preprocessSurface(IMG_Load(texture.path.c_str()), alphaFormat, opaqueFormat, options);
+		}
+	};
+
+	const size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), decode.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+
+	for (size_t i = 0; i < decode.size(); ++i) {
+		[[unlikely]] if (surfaces[i] == nullptr) {
+			SDL_Log("couldnt reload %s: %s", decode[i]->path.c_str(), SDL_GetError());
+			continue;
+		}
+		decode[i]->upload(window, surfaces[i]);
+	}
+}
+
+TextureDictionary::Stats TextureDictionary::stats() {
+	Stats stats;
+	for (const Slot& slot : slots) {
+		if (!slot.texture)
+			continue;
+
+		++stats.textures;
+		stats.bytes += slot.texture->bytes;
+		stats.fullBytes += slot.texture->fullBytes;
+	}
+	return stats;
+}
+
+AssetId TextureDictionary::intern(std::string_view path) {
+	SDLPP_TRACE_SCOPE("TextureDictionary::intern");
+
+	if (auto it = assetIds.find(path); it != assetIds.end())
+		return it->second;
+
+	AssetId id = static_cast<AssetId>(assetPaths.size());
+	assetPaths.emplace_back(path);
+	assetHandles.emplace_back();
+	assetIds.emplace(assetPaths.back(), id);
+	return id;
+}
+
+const std::string& TextureDictionary::pathOf(AssetId id) {
+	return assetPaths.at(id);
+}
+
+TextureHandle TextureDictionary::acquire(Window& window, AssetId id) {
+	SDLPP_TRACE_SCOPE("TextureDictionary::acquire");
+
+	TextureHandle& cached = assetHandles.at(id);
+	if (isValid(cached))
+		return cached;
+
+	attach(window);
+
+	// loaded before a slot is taken, so a file that doesnt load cant leave a slot behind
+	std::unique_ptr<Texture> texture = loadTexture(window, id);
+
+	// this is the first time we encounter this asset (or it was released), give it a slot
+	uint32_t index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		index = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+	}
+
+	Slot& slot = slots[index];
+	slot.texture = std::move(texture);
+	slot.asset = id;
+
+	cached = { index, slot.generation };
+	return cached;
+}
+
+Texture* TextureDictionary::get(TextureHandle handle) {
+	if (handle.index >= slots.size())
+		return nullptr;
+
+	const Slot& slot = slots[handle.index];
+	return slot.generation == handle.generation ? slot.texture.get() : nullptr;
+}
+
+bool TextureDictionary::isValid(TextureHandle handle) {
+	return get(handle) != nullptr;
+}
+
+void TextureDictionary::release(TextureHandle handle) {
+	if (!isValid(handle))
+		return;
+
+	Slot& slot = slots[handle.index];
+	slot.texture.reset();
+	// bumping the generation is what makes every outstanding copy of the handle stale
+	++slot.generation;
+	assetHandles[slot.asset] = {};
+	freeSlots.push_back(handle.index);
 }
 
 
@@ -98,7 +363,7 @@ Texture* TextureDictionary::loadTexture(Window& window, std::string_view p_fileP
 
 SurfaceTexture TextureDictionary::getSurfaceTexture(Window& window, std::string_view path) {
 	// no search for if its in the dictionary, as surface textures are user independent
-	return SurfaceTexture(window, path.data());
+	return SurfaceTexture(window, path);
 }
 
 SurfaceTexture TextureDictionary::reloadST(Window& window, std::string_view path) {
@@ -109,22 +374,25 @@ SurfaceTexture TextureDictionary::reloadST(Window& window, std::string_view path
 
 
 SpriteSheet TextureDictionary::getSpriteSheet(Window& window, std::string_view path, uint32_t tile_x, uint32_t tile_y) {
+	TextureHandle handle = acquire(window, intern(path));
 
-	if (textures.find(path.data()) == textures.end()) {
-		// element not found 
-		// this is the first time we encounter this path, generate a new Texture*
-		textures[path.data()] = loadTexture(window, path.data());
-	}
-	return SpriteSheet(tile_x, tile_y, textures[path.data()], path.data());
+	SpriteSheet sheet(tile_x, tile_y, get(handle), path);
+	sheet.handle = handle;
+	return sheet;
 }
 
 SpriteSheet TextureDictionary::reloadSS(Window& window, std::string_view path, uint32_t tile_x, uint32_t tile_y) {
-	(*textures.at(path.data())) = Texture(window, path);
-	return getSpriteSheet(window, path, tile_x, tile_y);
+	AssetId id = intern(path);
+
+	// reload in place so every sprite pointing at this Texture picks up the new one
+	if (Texture* texture = get(assetHandles[id]))
+		(*texture) = std::move(*loadTexture(window, id));
+
+	return getSpriteSheet(window, pathOf(id), tile_x, tile_y);
 }
 
 SurfaceSpriteSheet TextureDictionary::getSurfaceSpriteSheet(Window& window, std::string_view path, uint8_t tile_x, uint8_t tile_y) {
-	return SurfaceSpriteSheet(window, path.data(), tile_x, tile_y);
+	return SurfaceSpriteSheet(window, path, tile_x, tile_y);
 }
 
 SurfaceSpriteSheet TextureDictionary::reloadSSS(Window& window, std::string_view path, uint8_t tile_x, uint8_t tile_y) {
@@ -133,37 +401,61 @@ SurfaceSpriteSheet TextureDictionary::reloadSSS(Window& window, std::string_view
 
 
 Sprite TextureDictionary::getSprite(Window& window, std::string_view path) {
+	TextureHandle handle = acquire(window, intern(path));
 
-	if (textures.find(path.data()) == textures.end()) {
-		// element not found 
-		// this is the first time we encounter this path, generate a new Texture*
-		textures[path.data()] = loadTexture(window, path.data());
-	}
-	return Sprite(window, path.data(), textures[path.data()]);
+	Sprite sprite(window, path, get(handle));
+	sprite.handle = handle;
+	return sprite;
 }
 
 Sprite TextureDictionary::reloadSP(Window& window, std::string_view path) {
-	textures.erase(path.data());
-	(*textures.at(path.data())) = Texture(window, path);
-	return getSprite(window, path);
+	AssetId id = intern(path);
+
+	if (Texture* texture = get(assetHandles[id]))
+		(*texture) = std::move(*loadTexture(window, id));
+
+	return getSprite(window, pathOf(id));
 }
 
-void SurfaceSpriteSheet::load(Window& window, std::string path, int32_t x, int32_t y) {
+void SurfaceSpriteSheet::load(Window& window, std::string_view path, int32_t x, int32_t y) {
 	(*this) = TextureDictionary::getSurfaceSpriteSheet(window, path, x, y);
 }
 
 void SurfaceSpriteSheet::render(Window& renderer) {
-	
-	// this reloading is only neccesary when on android as when you rotate the screen the texture is for some reason not tied to the renderer anymore
-#ifdef WIN32
-	[[unlikely]]
-#endif
-	if (renderer.render(this->srcRect, this->destRect, this->texture))
-		return;
-	(*this) = TextureDictionary::reloadSSS(renderer, this->path, tile_x, tile_y);
+	[[unlikely]] if (this->texture == nullptr || this->dirty || this->epoch != renderer.get_reset_epoch())
+		this->createTexture(renderer);
+
+	applyModulation(this->texture, this->colorMod, this->blendMode);
 	renderer.render(this->srcRect, this->destRect, this->texture);
 }
 
 void SurfaceSpriteSheet::updateSection(uint16_t x, uint16_t y) {
 	this->srcRect = { x * tile_x, y * tile_y, tile_x, tile_y };
 }
+
+void SurfaceSpriteSheet::buildMasks(uint8_t alphaThreshold) {
+	masks.clear();
+	if (surface == nullptr || tile_x == 0 || tile_y == 0)
+		return;
+
+	const uint16_t columns = width / tile_x;
+	const uint16_t rows = height / tile_y;
+	masks.reserve(size_t(columns) * rows);
+
+	for (uint16_t y = 0; y < rows; ++y)
+		for (uint16_t x = 0; x < columns; ++x)
+			masks.push_back(CollisionMask::fromSurface(surface, { x * tile_x, y * tile_y, tile_x, tile_y }, alphaThreshold));
+}
+
+const CollisionMask& SurfaceSpriteSheet::maskFor(uint16_t x, uint16_t y) const {
+	static const CollisionMask none;
+	if (tile_x == 0 || x >= width / tile_x)
+		return none;
+
+	const size_t index = size_t(y) * (width / tile_x) + x;
+	return index < masks.size() ? masks[index] : none;
+}
+
+const CollisionMask& SurfaceSpriteSheet::maskFor() const {
+	return maskFor(uint16_t(srcRect.x / std::max<uint16_t>(tile_x, 1)), uint16_t(srcRect.y / std::max<uint16_t>(tile_y, 1)));
+}
@@ -1,24 +1,48 @@
 #pragma once
 
 
-#include <map>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
+#include <thread>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <exception>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
 #include "../SDLpp/Window.hpp"
+#include "preprocess.hpp"
+#include "collision.hpp"
+#include "raster.hpp"
 
 
 
+// compact id for an interned asset path, the same path always maps to the same id
+using AssetId = uint32_t;
+
+// generational handle into the TextureDictionary slot map
+// a handle goes stale when its slot is released, even if the slot gets reused afterwards
+struct TextureHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	constexpr bool operator==(const TextureHandle&) const = default;
+};
+
 class Texture {
 public:
 	Texture() = default;
-	Texture(Window& window, std::string_view path) :path(path) {
-		auto surface = IMG_Load(path.data());
+	Texture(Window& window, std::string_view path, const TextureLoadOptions& options = {}) :path(path), options(options) {
+		SDLPP_TRACE_SCOPE("Texture::Texture");
+
+		// string_view::data() isnt guaranteed to be null terminated, so load through our own copy
+		auto surface = IMG_Load(this->path.c_str());
 		if (surface == nullptr) [[unlikely]] {
 			throw std::runtime_error("a surface didnt load");
 		}
@@ -26,29 +50,86 @@ public:
 		width = surface->w;
 		height = surface->h;
 
-		this->texture = SDL_CreateTextureFromSurface(window.getRenderer(), surface);
-		SDL_FreeSurface(surface);
-
+		upload(window, preprocessSurface(window, surface, options));
 	}
-	Texture(const Texture& other) :
-		texture(other.texture),
-		path(other.path),
+	Texture(Texture&& other) noexcept :
+		texture(std::exchange(other.texture, nullptr)),
+		variants{ std::exchange(other.variants[0], nullptr), std::exchange(other.variants[1], nullptr) },
+		retained(std::exchange(other.retained, nullptr)),
+		path(std::move(other.path)),
+		options(other.options),
 		width(other.width),
-		height(other.height) {
-		if (texture)
-			SDL_DestroyTexture(texture);
-		this->texture = other.texture;
+		height(other.height),
+		bytes(other.bytes),
+		fullBytes(other.fullBytes) {}
+	Texture(const Texture& other) = delete;
+	Texture& operator=(const Texture&) = delete;
+	Texture& operator=(Texture&& other) noexcept {
+		destroy();
+		if (retained)
+			SDL_FreeSurface(retained);
+
+		this->texture = std::exchange(other.texture, nullptr);
+		this->variants[0] = std::exchange(other.variants[0], nullptr);
+		this->variants[1] = std::exchange(other.variants[1], nullptr);
+		this->retained = std::exchange(other.retained, nullptr);
+		this->path = std::move(other.path);
+		this->options = other.options;
+		this->width = other.width;
+		this->height = other.height;
+		this->bytes = other.bytes;
+		this->fullBytes = other.fullBytes;
+		return *this;
 	}
 	~Texture() {
-		if (texture)
-			SDL_DestroyTexture(texture);
+		destroy();
+		if (retained)
+			SDL_FreeSurface(retained);
 	}
 
+	// replaces the gpu side with an already preprocessed surface, uploading it and its downscaled variants
+	// the surface is kept as the retained copy when the options ask for it, otherwise it is freed
+	void upload(Window& window, SDL_Surface* surface);
 
-	SDL_Texture* texture;
+	// picks the smallest variant that still has at least as many pixels as dst
+	// src is rescaled in place to match the returned texture, a src of all zeros stays that way
+	inline SDL_Texture* select(SDL_Rect& src, const SDL_Rect& dst) const {
+		const int w = src.w ? src.w : width;
+		const int h = src.h ? src.h : height;
+
+		int level = 0;
+		while (level < 2 && variants[level] && (w >> (level + 1)) >= dst.w && (h >> (level + 1)) >= dst.h)
+			++level;
+
+		if (level == 0)
+			return texture;
+
+		src = { src.x >> level, src.y >> level, src.w >> level, src.h >> level };
+		return variants[level - 1];
+	}
+
+
+	SDL_Texture* texture = nullptr;
+	// half and quarter size copies, only present when loaded with downscaleLevels
+	SDL_Texture* variants[2] = { nullptr, nullptr };
+	// the preprocessed pixels, only kept with TextureLoadOptions::retainSurface
+	SDL_Surface* retained = nullptr;
 	std::string path;
-	uint16_t width;
-	uint16_t height;
+	TextureLoadOptions options;
+	uint16_t width = 0;
+	uint16_t height = 0;
+	// gpu memory of the texture and its variants as stored, and what it would have been at 32 bits per pixel
+	size_t bytes = 0;
+	size_t fullBytes = 0;
+
+private:
+	inline void destroy() {
+		if (texture)
+			SDL_DestroyTexture(std::exchange(texture, nullptr));
+		for (SDL_Texture*& variant : variants)
+			if (variant)
+				SDL_DestroyTexture(std::exchange(variant, nullptr));
+	}
 };
 
 
@@ -56,9 +137,11 @@ class Renderable {
 public:
 	Renderable() :texture(nullptr) {}
 	Renderable(Texture* tex) :texture(tex) {}
-	virtual void load(Window& window, std::string path, int32_t tile_x, int32_t tile_y) = 0;
+	virtual void load(Window& window, std::string_view path, int32_t tile_x, int32_t tile_y) = 0;
 	virtual void render(Window& renderer) = 0;
 	Texture* texture;
+	// the dictionary slot the texture lives in, stays invalid for textures the dictionary doesnt own
+	TextureHandle handle;
 };
 
 
@@ -73,8 +156,10 @@ public:
 		this->destRect = { 0, 0, 0, 0 };
 	}
 
-	void load(Window& window, std::string path, int32_t x = 0, int32_t y = 0) override;
+	void load(Window& window, std::string_view path, int32_t x = 0, int32_t y = 0) override;
 	void render(Window& renderer) override;
+	// draws through the windows deferred queue instead of right away
+	void queue(Window& window, uint8_t layer, uint32_t depth = 0);
 
 	SDL_Rect srcRect = { 0,0,0,0 };
 	SDL_Rect destRect = { 0,0,0,0 };
@@ -85,7 +170,7 @@ public:
 class SpriteSheet : public Renderable {
 public:
 	SpriteSheet() :Renderable(), srcRect({ 0,0,0,0 }), destRect({ 0,0,0,0 }), tile_x(0), tile_y(0) {};
-	SpriteSheet(uint8_t tile_x, uint8_t tile_y, Texture* tex, std::string path) : Renderable(tex), tile_x(tile_x), tile_y(tile_y) {
+	SpriteSheet(uint8_t tile_x, uint8_t tile_y, Texture* tex, std::string_view path) : Renderable(tex), tile_x(tile_x), tile_y(tile_y) {
 
 		// set class members
 		this->srcRect = { 0, 0, tile_x, tile_y };
@@ -95,8 +180,9 @@ public:
 	~SpriteSheet() {}
 
 	// the x and y are 0,0 on the top left of the texture
-	void load(Window& window, std::string path, int32_t tile_x, int32_t tile_y) override;
+	void load(Window& window, std::string_view path, int32_t tile_x, int32_t tile_y) override;
 	void render(Window& window) override;
+	void queue(Window& window, uint8_t layer, uint32_t depth = 0);
 	void updateSection(uint8_t x, uint8_t y);
 	SDL_Rect srcRect = { 0,0,0,0 };
 	SDL_Rect destRect = { 0,0,0,0 };
@@ -117,22 +203,23 @@ public:
 		path(),
 		destRect({}) {};
 	SurfaceTexture(Window& window, int w, int h) {
-		this->surface = SDL_CreateRGBSurface(0, w, h, 32, 
-			0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+		// in the renderers own format so the uploads after every change dont have to convert
+		this->surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, nativeTextureFormat(window, true));
 		this->texture = nullptr;
 		this->destRect = { 0, 0, w, h };
 
-		window.setDrawColor(0, 0, 0, 255);
+		window.set_draw_color(0, 0, 0, 255);
 		this->drawRectFilled(window, destRect);
 	}
 
-	SurfaceTexture(Window& window, std::string_view path) {
+	SurfaceTexture(Window& window, std::string_view path) : path(path) {
 
-		surface = IMG_Load(path.data());
+		// converted once here so every createTexture afterwards is a straight upload
+		surface = preprocessSurface(window, IMG_Load(this->path.c_str()), {}, true);
 
 		destRect = {};
 
-		this->texture = SDL_CreateTextureFromSurface(window.getRenderer(), surface);
+		this->texture = SDL_CreateTextureFromSurface(window.get_renderer(), surface);
 		if (texture == NULL || surface == NULL) {
 			std::string error = "setSurfaceColorMod failed because: ";
 
@@ -140,27 +227,22 @@ public:
 
 			throw std::runtime_error(error);
 		}
-
-		this->path = path;
+		this->epoch = window.get_reset_epoch();
+		buildMask();
 	}
 
 	SurfaceTexture(SurfaceTexture&& other) :
+		surface(std::exchange(other.surface, nullptr)),
+		texture(std::exchange(other.texture, nullptr)),
 		path(std::move(other.path)),
-		destRect(other.destRect) {
-
-		if (surface)
-			SDL_FreeSurface(this->surface);
-
-		surface = other.surface;
-		other.surface = nullptr;
-
-		if (this->texture)
-			SDL_DestroyTexture(this->texture);
-
-		texture = other.texture;
-		other.texture = nullptr;
-
-	}
+		destRect(other.destRect),
+		storage(other.storage),
+		dither(other.dither),
+		epoch(other.epoch),
+		mask(std::move(other.mask)),
+		colorMod(other.colorMod),
+		blendMode(other.blendMode),
+		dirty(other.dirty) {}
 
 	SurfaceTexture(const SurfaceTexture& other) = delete;
 
@@ -169,6 +251,13 @@ public:
 	SurfaceTexture& operator=(SurfaceTexture&& other) {
 		this->path = std::move(other.path);
 		this->destRect = other.destRect;
+		this->storage = other.storage;
+		this->dither = other.dither;
+		this->epoch = other.epoch;
+		this->mask = std::move(other.mask);
+		this->colorMod = other.colorMod;
+		this->blendMode = other.blendMode;
+		this->dirty = other.dirty;
 
 		if (this->surface)
 			SDL_FreeSurface(this->surface);
@@ -189,65 +278,73 @@ public:
 		if (this->texture)
 			SDL_DestroyTexture(this->texture);
 	}
-	void load(Window& window, std::string path, int32_t x = 0, int32_t y = 0) override;
+	void load(Window& window, std::string_view path, int32_t x = 0, int32_t y = 0) override;
 	void createSurface(Window& window, int32_t x, int32_t y);
 
 	// util
 	void drawRectFilled(Window& window, SDL_Rect dest);
 	void blitSurface(Window& window, SDL_Surface* src, SDL_Rect dest);
+	// these use the window draw colour like drawRectFilled, raster.hpp takes the colour directly for use off the main thread
+	void drawLine(Window& window, float x0, float y0, float x1, float y1);
+	void drawCircle(Window& window, int32_t x, int32_t y, int32_t radius);
+	void drawCircleFilled(Window& window, int32_t x, int32_t y, int32_t radius);
+	void drawEllipse(Window& window, int32_t x, int32_t y, int32_t rx, int32_t ry);
+	void drawEllipseFilled(Window& window, int32_t x, int32_t y, int32_t rx, int32_t ry);
+	void drawPolygonFilled(Window& window, const SDL_FPoint* points, size_t count);
 	void render(Window& renderer) override;
 
-	// call this after youve made modifications using the other utility functions to "save" the changes into the texture
+	// rebuilds mask from the surface, the path constructor does this at load, call it again after drawing into the surface
+	void buildMask(uint8_t alphaThreshold = 0);
+
+	// render does this by itself when the surface changed, calling it only moves the upload to a time of your choosing
 	inline void createTexture(Window& window) {
 		if (texture)
 			SDL_DestroyTexture(texture);
 
-		texture = SDL_CreateTextureFromSurface(window.getRenderer(), surface);
+		TextureLoadOptions options;
+		options.storage = storage;
+		options.dither = dither;
+		texture = createPreprocessedTexture(window, surface, options);
+		epoch = window.get_reset_epoch();
+		dirty = false;
 	}
 
-	inline void setSurfaceAlphaMod(Window& window, Uint8 a) {
-
-		[[unlikely]] if (SDL_SetSurfaceAlphaMod(surface, a) != 0) {
-
-			std::string error = "setSurfaceAlphaMod failed because: ";
-
-			error += SDL_GetError();
-
-			throw std::runtime_error(error);
-		}
-		createTexture(window);
+	// modulation is texture state applied on every draw, changing it never touches the pixels or uploads anything
+	inline void setSurfaceAlphaMod([[maybe_unused]] Window& window, Uint8 a) {
+		colorMod.a = a;
 	}
 
-	inline void setSurfaceBlendMode(Window& window, SDL_BlendMode blend) {
-
-		[[unlikely]] if (SDL_SetSurfaceBlendMode(surface, blend)) {
-
-			std::string error = "SDL_SetSurfaceBlendMode failed because: ";
-
-			error += SDL_GetError();
-
-			throw error;
-		}
-		createTexture(window);
+	inline void setSurfaceBlendMode([[maybe_unused]] Window& window, SDL_BlendMode blend) {
+		blendMode = blend;
 	}
 
-	inline void setSurfaceColorMod(Window& window, Uint8 r, Uint8 g, Uint8 b) {
-
-		[[unlikely]] if (SDL_SetSurfaceColorMod(surface, r, g, b) != 0) {
-			std::string error = "setSurfaceColorMod failed because: ";
-
-			error += SDL_GetError();
-
-			throw std::runtime_error(error);
+	inline void setSurfaceColorMod([[maybe_unused]] Window& window, Uint8 r, Uint8 g, Uint8 b) {
+		colorMod.r = r;
+		colorMod.g = g;
+		colorMod.b = b;
+	}
 
-		}
-		createTexture(window);
+	// call this after changing the pixels of surface directly so the next render uploads them
+	inline void markDirty() {
+		dirty = true;
 	}
 
 	SDL_Surface* surface;
 	SDL_Texture* texture;
 	std::string path;
 	SDL_Rect destRect;
+	// the surface stays 32 bits for drawing into, this only changes what createTexture uploads
+	TextureStorage storage = TextureStorage::Full;
+	bool dither = false;
+	// the window reset epoch the texture was made in
+	uint32_t epoch = 0;
+	// solid pixels of the whole surface
+	CollisionMask mask;
+	SDL_Color colorMod = { 255, 255, 255, 255 };
+	// SDL_BLENDMODE_INVALID leaves the blend mode the texture was created with
+	SDL_BlendMode blendMode = SDL_BLENDMODE_INVALID;
+	// the surface has changes the texture doesnt have yet
+	bool dirty = false;
 };
 
 class SurfaceSpriteSheet : public Renderable {
@@ -261,39 +358,40 @@ public:
 		destRect({}),
 		width(0), height(0),
 		tile_x(0), tile_y(0) {};
-	SurfaceSpriteSheet(Window& window, std::string_view path, uint16_t tile_x, uint16_t tile_y) {
-		surface = IMG_Load(path.data());
+	SurfaceSpriteSheet(Window& window, std::string_view path, uint16_t tile_x, uint16_t tile_y) : path(path) {
+		surface = preprocessSurface(window, IMG_Load(this->path.c_str()), {}, true);
 		srcRect = {0,0,tile_x,tile_y};
 		destRect = {};
 		width = surface->w;
 		height = surface->h;
 		this->tile_x = tile_x;
 		this->tile_y = tile_y;
-		this->texture = SDL_CreateTextureFromSurface(window.getRenderer(), surface);
+		this->texture = SDL_CreateTextureFromSurface(window.get_renderer(), surface);
 		if (texture == NULL || surface == NULL) {
 			std::string error = "setSurfaceColorMod failed because: ";
 			error += SDL_GetError();
 			throw std::runtime_error(error);
 		}
-		this->path = path;
+		this->epoch = window.get_reset_epoch();
+		buildMasks();
 	}
 	SurfaceSpriteSheet(SurfaceSpriteSheet&& other) :
+		surface(std::exchange(other.surface, nullptr)),
+		texture(std::exchange(other.texture, nullptr)),
 		path(std::move(other.path)),
 		srcRect(other.srcRect),
 		destRect(other.destRect),
 		width(other.width),
 		height(other.height),
 		tile_x(other.tile_x),
-		tile_y(other.tile_y) {
-		if (surface)
-			SDL_FreeSurface(this->surface);
-		surface = other.surface;
-		other.surface = nullptr;
-		if (this->texture)
-			SDL_DestroyTexture(this->texture);
-		texture = other.texture;
-		other.texture = nullptr;
-	}
+		tile_y(other.tile_y),
+		storage(other.storage),
+		dither(other.dither),
+		epoch(other.epoch),
+		masks(std::move(other.masks)),
+		colorMod(other.colorMod),
+		blendMode(other.blendMode),
+		dirty(other.dirty) {}
 	SurfaceSpriteSheet(const SurfaceSpriteSheet& other) = delete;
 	SurfaceSpriteSheet& operator= (const SurfaceSpriteSheet&) = delete;
 	SurfaceSpriteSheet& operator=(SurfaceSpriteSheet&& other) {
@@ -304,6 +402,13 @@ public:
 		this->height = other.height;
 		this->tile_x = other.tile_x;
 		this->tile_y = other.tile_y;
+		this->storage = other.storage;
+		this->dither = other.dither;
+		this->epoch = other.epoch;
+		this->masks = std::move(other.masks);
+		this->colorMod = other.colorMod;
+		this->blendMode = other.blendMode;
+		this->dirty = other.dirty;
 		if (this->surface)
 			SDL_FreeSurface(this->surface);
 		this->surface = std::exchange(other.surface, nullptr);
@@ -319,57 +424,49 @@ public:
 			SDL_DestroyTexture(this->texture);
 	}
 
-	inline void setSurfaceAlphaMod(Window& window, Uint8 a) {
-
-		[[unlikely]] if (SDL_SetSurfaceAlphaMod(surface, a) != 0) {
-
-			std::string error = "setSurfaceAlphaMod failed because: ";
-
-			error += SDL_GetError();
-
-			throw std::runtime_error(error);
-		}
-		createTexture(window);
+	// modulation is texture state applied on every draw, changing it never touches the pixels or uploads anything
+	inline void setSurfaceAlphaMod([[maybe_unused]] Window& window, Uint8 a) {
+		colorMod.a = a;
 	}
 
-	inline void setSurfaceBlendMode(Window& window, SDL_BlendMode blend) {
-
-		[[unlikely]] if (SDL_SetSurfaceBlendMode(surface, blend)) {
-
-			std::string error = "SDL_SetSurfaceBlendMode failed because: ";
-
-			error += SDL_GetError();
-
-			throw std::runtime_error(error);
-		}
-		createTexture(window);
+	inline void setSurfaceBlendMode([[maybe_unused]] Window& window, SDL_BlendMode blend) {
+		blendMode = blend;
 	}
 
-	inline void setSurfaceColorMod(Window& window, Uint8 r, Uint8 g, Uint8 b) {
-
-		[[unlikely]] if (SDL_SetSurfaceColorMod(surface, r, g, b) != 0) {
-			std::string error = "setSurfaceColorMod failed because: ";
-
-			error += SDL_GetError();
-
-			throw std::runtime_error(error);
+	inline void setSurfaceColorMod([[maybe_unused]] Window& window, Uint8 r, Uint8 g, Uint8 b) {
+		colorMod.r = r;
+		colorMod.g = g;
+		colorMod.b = b;
+	}
 
-		}
-		createTexture(window);
+	// call this after changing the pixels of surface directly so the next render uploads them
+	inline void markDirty() {
+		dirty = true;
 	}
 
-	// call this after youve made modifications using the other utility functions to "save" the changes into the texture
+	// render does this by itself when the surface changed, calling it only moves the upload to a time of your choosing
 	inline void createTexture(Window& window) {
 		if (texture)
 			SDL_DestroyTexture(texture);
 
-		texture = SDL_CreateTextureFromSurface(window.getRenderer(), surface);
+		TextureLoadOptions options;
+		options.storage = storage;
+		options.dither = dither;
+		texture = createPreprocessedTexture(window, surface, options);
+		epoch = window.get_reset_epoch();
+		dirty = false;
 	}
 
-	void load(Window& window, std::string path, int32_t x = 0, int32_t y = 0) override;
+	void load(Window& window, std::string_view path, int32_t x = 0, int32_t y = 0) override;
 	void render(Window& renderer) override;
 	void updateSection(uint16_t x, uint16_t y);
 
+	// one mask per tile in row major order, the path constructor does this at load
+	void buildMasks(uint8_t alphaThreshold = 0);
+	// the mask of tile (x, y), or of the section picked by updateSection when called without arguments
+	const CollisionMask& maskFor(uint16_t x, uint16_t y) const;
+	const CollisionMask& maskFor() const;
+
 	SDL_Surface* surface;
 	SDL_Texture* texture;
 	std::string path;
@@ -379,6 +476,16 @@ public:
 	uint16_t height;
 	uint16_t tile_x;
 	uint16_t tile_y;
+	// the surface stays 32 bits, this only changes what createTexture uploads
+	TextureStorage storage = TextureStorage::Full;
+	bool dither = false;
+	// the window reset epoch the texture was made in
+	uint32_t epoch = 0;
+	std::vector<CollisionMask> masks;
+	SDL_Color colorMod = { 255, 255, 255, 255 };
+	// SDL_BLENDMODE_INVALID leaves the blend mode the texture was created with
+	SDL_BlendMode blendMode = SDL_BLENDMODE_INVALID;
+	bool dirty = false;
 };
 
 
@@ -393,7 +500,66 @@ public:
 	static SurfaceSpriteSheet getSurfaceSpriteSheet(Window& window, std::string_view path, uint8_t tile_x, uint8_t tile_y);
 	static SurfaceSpriteSheet reloadSSS(Window& window, std::string_view path, uint8_t tile_x, uint8_t tile_y);
 
+	// interns the path and returns its id, this is the only string lookup on the path
+	static AssetId intern(std::string_view path);
+	static const std::string& pathOf(AssetId id);
+
+	// returns the cached handle for the asset, loading the texture the first time its asked for
+	static TextureHandle acquire(Window& window, AssetId id);
+	// O(1) slot lookup, returns nullptr if the handle is stale
+	static Texture* get(TextureHandle handle);
+	static bool isValid(TextureHandle handle);
+	// destroys the texture and invalidates every handle pointing at it, sprites holding one stop drawing
+	static void release(TextureHandle handle);
+
+	// applied to every texture the dictionary loads from now on
+	static void setLoadOptions(const TextureLoadOptions& options) { loadOptions = options; }
+	static const TextureLoadOptions& getLoadOptions() { return loadOptions; }
+	// overrides the storage from the load options for one asset, takes effect the next time it loads
+	static void setStorage(std::string_view path, TextureStorage storage);
+
+	struct Stats {
+		size_t textures = 0;
+		// gpu memory of every resident texture as stored
+		size_t bytes = 0;
+		// what the same textures would take at 32 bits per pixel
+		size_t fullBytes = 0;
+
+		size_t saved() const { return fullBytes - bytes; }
+	};
+	static Stats stats();
+
+	// recreates every resident texture in one pass, from the retained surfaces where there are some
+	// and by decoding the rest in parallel otherwise, the Texture* sprites hold stay valid
+	static void reuploadAll(Window& window);
+	// makes the window call reuploadAll when its device is lost, acquire does this on its own, attaching twice does nothing
+	static void attach(Window& window);
+
 private:
-	static Texture* loadTexture(Window& window, std::string_view p_filePath);
-	static inline std::map<std::string, Texture*> textures;
+	struct Slot {
+		// heap allocated so the Texture* held by sprites survives the slot vector growing
+		std::unique_ptr<Texture> texture;
+		uint32_t generation = 0;
+		AssetId asset = 0;
+	};
+
+	// hashes the keys and the string_views they are searched with the same way
+	struct PathHash {
+		using is_transparent = void;
+		size_t operator()(std::string_view path) const noexcept { return std::hash<std::string_view>{}(path); }
+	};
+
+	static std::unique_ptr<Texture> loadTexture(Window& window, AssetId id);
+
+	static inline TextureLoadOptions loadOptions;
+	static inline std::unordered_map<AssetId, TextureStorage> storageOverrides;
+
+	// the keys point into assetPaths
+	static inline std::unordered_map<std::string_view, AssetId, PathHash, std::equal_to<>> assetIds;
+	// indexed by AssetId, a deque so the strings assetIds points into never move once interned
+	static inline std::deque<std::string> assetPaths;
+	static inline std::vector<TextureHandle> assetHandles;
+
+	static inline std::vector<Slot> slots;
+	static inline std::vector<uint32_t> freeSlots;
 };
\ No newline at end of file
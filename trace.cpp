@@ -0,0 +1,150 @@
+#include "trace.hpp"
+
+#ifdef SDLPP_TRACING
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+    namespace {
+        // written by its own thread only, so recording is a store and a release, no locks and no atomics read-modify-write
+        struct ThreadBuffer {
+            std::unique_ptr<Event[]> events{ new Event[events_per_thread] };
+            std::atomic<uint64_t> written{ 0 };
+            uint32_t tid = 0;
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            // buffers outlive their threads so a trace still shows threads that already finished
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        };
+
+        // never destroyed, threads can still be recording while statics are torn down at exit
+        Registry& registry() {
+            static Registry* instance = new Registry();
+            return *instance;
+        }
+
+        ThreadBuffer& local_buffer() {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (buffer == nullptr) [[unlikely]] {
+                Registry& reg = registry();
+                std::lock_guard lock(reg.mutex);
+                reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer = reg.buffers.back().get();
+                buffer->tid = uint32_t(reg.buffers.size());
+            }
+            return *buffer;
+        }
+
+        std::atomic<bool> trigger_armed{ false };
+        std::atomic<uint64_t> trigger_threshold{ 0 };
+        std::mutex trigger_mutex;
+        std::string trigger_path;
+
+        uint64_t last_frame = 0;
+
+        void write_escaped(std::FILE* file, const char* text) {
+            for (; *text; ++text) {
+                const char c = *text;
+                if (c == '"' || c == '\\')
+                    std::fputc('\\', file);
+                if (static_cast<unsigned char>(c) < 0x20)
+                    std::fprintf(file, "\\u%04x", c);
+                else
+                    std::fputc(c, file);
+            }
+        }
+    }
+
+    uint64_t now() {
+        using clock = std::chrono::steady_clock;
+        static const clock::time_point start = clock::now();
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+
+    void record(const char* name, uint64_t start, uint64_t duration) {
+        ThreadBuffer& buffer = local_buffer();
+        const uint64_t n = buffer.written.load(std::memory_order_relaxed);
+        buffer.events[n & (events_per_thread - 1)] = { name, start, duration };
+        buffer.written.store(n + 1, std::memory_order_release);
+    }
+
+    bool write_chrome_json(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+        bool first = true;
+
+        std::vector<Event> copy;
+        Registry& reg = registry();
+        std::lock_guard lock(reg.mutex);
+
+        for (const auto& buffer : reg.buffers) {
+            const uint64_t end = buffer->written.load(std::memory_order_acquire);
+            const uint64_t begin = end > events_per_thread ? end - events_per_thread : 0;
+
+            copy.clear();
+            for (uint64_t i = begin; i < end; ++i)
+                copy.push_back(buffer->events[i & (events_per_thread - 1)]);
+
+            // the owning thread kept going, anything it could have written over while we copied is dropped
+            const uint64_t after = buffer->written.load(std::memory_order_acquire);
+            const uint64_t safe = after >= events_per_thread ? after - events_per_thread + 1 : 0;
+
+            for (uint64_t i = std::max(begin, safe); i < end; ++i) {
+                const Event& event = copy[i - begin];
+
+                std::fputs(first ? "\n{\"name\":\"" : ",\n{\"name\":\"", file);
+                first = false;
+                write_escaped(file, event.name);
+
+                // chrome wants microseconds
+                if (event.duration == 0)
+                    std::fprintf(file, "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                        event.start / 1000.0, buffer->tid);
+                else
+                    std::fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                        event.start / 1000.0, event.duration / 1000.0, buffer->tid);
+            }
+        }
+
+        std::fputs("\n]}\n", file);
+        return std::fclose(file) == 0;
+    }
+
+    void set_frame_trigger(double threshold_ms, std::string path) {
+        std::lock_guard lock(trigger_mutex);
+        trigger_path = std::move(path);
+        trigger_threshold.store(uint64_t(threshold_ms * 1e6), std::memory_order_relaxed);
+        trigger_armed.store(true, std::memory_order_release);
+    }
+
+    void end_frame() {
+        const uint64_t t = now();
+        const uint64_t duration = last_frame ? t - last_frame : 0;
+        if (last_frame)
+            record("frame", last_frame, duration);
+        last_frame = t;
+
+        if (!trigger_armed.load(std::memory_order_acquire) || duration <= trigger_threshold.load(std::memory_order_relaxed))
+            return;
+
+        std::string path;
+        {
+            std::lock_guard lock(trigger_mutex);
+            if (!trigger_armed.exchange(false))
+                return;
+            path = trigger_path;
+        }
+        write_chrome_json(path);
+    }
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+// scoped zones and instant events for finding out why a single frame spiked, written out in the
+// chrome trace event format, load the file in chrome://tracing or ui.perfetto.dev
+// everything here only exists when SDLPP_TRACING is defined, otherwise the macros expand to nothing
+//
+//     SDLPP_TRACE_SCOPE("physics");     // times until the end of the enclosing block
+//     SDLPP_TRACE_INSTANT("spawned");   // a single point in time
+//
+// names have to outlive the trace, string literals are the intended use
+
+#ifdef SDLPP_TRACING
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace trace {
+    // nanoseconds since the first traced event
+    uint64_t now();
+
+    // every thread writes into its own ring of this many events, the oldest ones get overwritten
+    constexpr size_t events_per_thread = 1 << 16;
+
+    struct Event {
+        const char* name;
+        uint64_t start;
+        // 0 marks an instant event
+        uint64_t duration;
+    };
+
+    void record(const char* name, uint64_t start, uint64_t duration);
+
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name(name), start(now()) {}
+        ~Scope() { record(name, start, now() - start); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        uint64_t start;
+    };
+
+    // writes what every thread still has in its ring, returns false if the file couldnt be opened
+    // threads can keep tracing while this runs, events they overwrite during the copy are left out
+    bool write_chrome_json(const std::string& path);
+
+    // the next frame longer than threshold_ms writes the trace to path, then the trigger disarms itself
+    // so a run of slow frames only costs one write, call it again to rearm
+    void set_frame_trigger(double threshold_ms, std::string path);
+    // called by Window::display once per frame, records the frame as a zone and checks the trigger
+    void end_frame();
+}
+
+#define SDLPP_TRACE_CONCAT_INNER(a, b) a##b
+#define SDLPP_TRACE_CONCAT(a, b) SDLPP_TRACE_CONCAT_INNER(a, b)
+#define SDLPP_TRACE_SCOPE(name) ::trace::Scope SDLPP_TRACE_CONCAT(sdlpp_trace_scope_, __LINE__)(name)
+#define SDLPP_TRACE_INSTANT(name) ::trace::record((name), ::trace::now(), 0)
+#define SDLPP_TRACE_FRAME() ::trace::end_frame()
+
+#else
+
+#define SDLPP_TRACE_SCOPE(name) ((void)0)
+#define SDLPP_TRACE_INSTANT(name) ((void)0)
+#define SDLPP_TRACE_FRAME() ((void)0)
+
+#endif